@@ -1,5 +1,3 @@
-
-
 #define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,103 +7,67 @@
 #include <errno.h>
 #include <stdint.h>
 
-#ifndef CLOCK_MONOTONIC
-#define CLOCK_MONOTONIC 1
-#endif
-
-static volatile size_t sink_size;
-static volatile void *sink_ptr;
-static volatile int sink_int;
-static volatile double sink_double;
-
-typedef struct
-{
-    const char *name;
-    void (*init)(void **state);
-    size_t (*run)(void *state, size_t iters);
-    void (*cleanup)(void *state);
-} Benchmark;
-
-/* Time utility */
-static inline uint64_t now_ns(void)
-{
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
-}
-
-#if defined(__GNUC__) || defined(__clang__)
-#define likely(x) (__builtin_expect(!!(x), 1))
-#define unlikely(x) (__builtin_expect(!!(x), 0))
-#else
-#define likely(x) (x)
-#define unlikely(x) (x)
-#endif
-
-static void
-die(const char *msg)
-{
-    fprintf(stderr, "FATAL: %s\n", msg);
-    exit(1);
-}
-
-#if defined(_MSC_VER)
-__declspec(noinline)
-#elif defined(__GNUC__) || defined(__clang__)
-__attribute__((cold, noinline))
-#endif
-static void
-out_of_memory_error()
-{
-    die("out of memory");
-}
-
-static inline void *xmalloc(size_t n)
-{
-    void *p = malloc(n ? n : 1);
-    if unlikely (!p)
-    {
-        out_of_memory_error();
-    }
-    return p;
-}
+#include "libcbench.h"
 
 /* ---------------- Benchmarks ---------------- */
 
 /* 1. strlen */
+typedef struct
+{
+    bench_ring ring;
+} strlen_state;
 static void init_strlen(void **state)
 {
-    char *s = xmalloc(1025);
+    strlen_state *st = xmalloc(sizeof(*st));
+    char s[1025];
     for (int i = 0; i < 1024; i++)
         s[i] = 'A' + (i % 26);
     s[1024] = '\0';
-    *state = s;
+    bench_ring_init(&st->ring, s, sizeof(s));
+    *state = st;
 }
 static size_t run_strlen(void *state, size_t iters)
 {
-    char *s = (char *)state;
+    strlen_state *st = (strlen_state *)state;
     size_t ops = 0;
     for (size_t i = 0; i < iters; i++)
     {
-        size_t len = strlen(s);
-        sink_size = len;
+        size_t len = strlen(bench_ring_next(&st->ring));
+        BENCH_DO_NOT_OPTIMIZE(len);
         ops++;
     }
     return ops;
 }
-static void cleanup_free(void *state) { free(state); }
+/* Frees any state that is a struct whose first member is its bench_ring */
+static void cleanup_ring(void *state)
+{
+    bench_ring_free((bench_ring *)state);
+    free(state);
+}
+/* Same for a struct that starts with a source and a destination ring */
+static void cleanup_ring_pair(void *state)
+{
+    bench_ring *rings = (bench_ring *)state;
+    bench_ring_free(&rings[0]);
+    bench_ring_free(&rings[1]);
+    free(state);
+}
 
 /* 2. strcmp */
 typedef struct
 {
-    char *a;
-    char *b;
+    bench_ring ring; /* each slot: a, then b at b_off */
+    size_t b_off;
 } strcmp_state;
 static void init_strcmp(void **state)
 {
     strcmp_state *st = xmalloc(sizeof(*st));
-    st->a = strdup("The quick brown fox jumps over the lazy dog 1234567890");
-    st->b = strdup("The quick brown fox jumps over the lazy dog 1234567890");
+    static const char text[] = "The quick brown fox jumps over the lazy dog 1234567890";
+    char tmpl[2 * sizeof(text)];
+    memcpy(tmpl, text, sizeof(text));
+    memcpy(tmpl + sizeof(text), text, sizeof(text));
+    st->b_off = sizeof(text);
+    bench_ring_init(&st->ring, tmpl, sizeof(tmpl));
     *state = st;
 }
 static size_t run_strcmp(void *state, size_t iters)
@@ -114,34 +76,29 @@ static size_t run_strcmp(void *state, size_t iters)
     size_t ops = 0;
     for (size_t i = 0; i < iters; i++)
     {
-        int r = strcmp(st->a, st->b);
-        sink_int = r;
+        char *a = bench_ring_next(&st->ring);
+        int r = strcmp(a, a + st->b_off);
+        BENCH_DO_NOT_OPTIMIZE(r);
         ops++;
     }
     return ops;
 }
-static void cleanup_strcmp(void *state)
-{
-    strcmp_state *st = (strcmp_state *)state;
-    free(st->a);
-    free(st->b);
-    free(st);
-}
 
 /* 3. strcpy */
 typedef struct
 {
-    char *src;
-    char *dst;
+    bench_ring ring; /* each slot: 2048-byte src, then dst */
 } strcpy_state;
 static void init_strcpy(void **state)
 {
     strcpy_state *st = xmalloc(sizeof(*st));
-    st->src = xmalloc(2048);
+    char *tmpl = xmalloc(4096);
     for (int i = 0; i < 2047; i++)
-        st->src[i] = 'a' + (i % 26);
-    st->src[2047] = '\0';
-    st->dst = xmalloc(2048);
+        tmpl[i] = 'a' + (i % 26);
+    tmpl[2047] = '\0';
+    memset(tmpl + 2048, 0, 2048);
+    bench_ring_init(&st->ring, tmpl, 4096);
+    free(tmpl);
     *state = st;
 }
 static size_t run_strcpy(void *state, size_t iters)
@@ -150,31 +107,27 @@ static size_t run_strcpy(void *state, size_t iters)
     size_t ops = 0;
     for (size_t i = 0; i < iters; i++)
     {
-        char *r = strcpy(st->dst, st->src);
-        sink_ptr = r;
+        char *src = bench_ring_next(&st->ring);
+        char *r = strcpy(src + 2048, src);
+        BENCH_DO_NOT_OPTIMIZE(r);
         ops++;
     }
     return ops;
 }
-static void cleanup_strcpy(void *state)
-{
-    strcpy_state *st = (strcpy_state *)state;
-    free(st->src);
-    free(st->dst);
-    free(st);
-}
 
 /* 4. strcat */
 typedef struct
 {
-    char *piece;
-    char *buf;
+    bench_ring src; /* the piece */
+    bench_ring dst; /* the 1024-byte buffer it is appended to */
 } strcat_state;
 static void init_strcat(void **state)
 {
     strcat_state *st = xmalloc(sizeof(*st));
-    st->piece = strdup("segment1234567890");
-    st->buf = xmalloc(1024);
+    static const char piece[] = "segment1234567890";
+    char buf[1024] = {0};
+    bench_ring_init(&st->src, piece, sizeof(piece));
+    bench_ring_init(&st->dst, buf, sizeof(buf));
     *state = st;
 }
 static size_t run_strcat(void *state, size_t iters)
@@ -183,36 +136,33 @@ static size_t run_strcat(void *state, size_t iters)
     size_t ops = 0;
     for (size_t i = 0; i < iters; i++)
     {
-        st->buf[0] = '\0';
+        const char *piece = bench_ring_next(&st->src);
+        char *buf = bench_ring_next(&st->dst);
+        buf[0] = '\0';
         for (int k = 0; k < 16; k++)
         {
-            char *r = strcat(st->buf, st->piece);
-            sink_ptr = r;
+            char *r = strcat(buf, piece);
+            BENCH_DO_NOT_OPTIMIZE(r);
             ops++;
         }
     }
     return ops;
 }
-static void cleanup_strcat(void *state)
-{
-    strcat_state *st = (strcat_state *)state;
-    free(st->piece);
-    free(st->buf);
-    free(st);
-}
 
 /* 5. strchr */
 typedef struct
 {
-    char *s;
+    bench_ring ring;
 } strchr_state;
 static void init_strchr(void **state)
 {
     strchr_state *st = xmalloc(sizeof(*st));
-    st->s = xmalloc(4097);
+    char *s = xmalloc(4097);
     for (int i = 0; i < 4096; i++)
-        st->s[i] = 'a' + (i % 26);
-    st->s[4096] = '\0';
+        s[i] = 'a' + (i % 26);
+    s[4096] = '\0';
+    bench_ring_init(&st->ring, s, 4097);
+    free(s);
     *state = st;
 }
 static size_t run_strchr(void *state, size_t iters)
@@ -221,45 +171,34 @@ static size_t run_strchr(void *state, size_t iters)
     /* Vary target each iteration so the call can't be constant-folded. */
     static volatile char targets[] = "abcdefghijklmnopqrstuvwxyz";
     size_t ops = 0;
-    int acc = 0;
     for (size_t i = 0; i < iters; i++)
     {
         char target = targets[i % (sizeof(targets) - 1)];
-        const char *r = strchr(st->s, target);
-        /* Consume result in a way the compiler can't predict fully. */
-        if (r)
-            acc += (int)(r - st->s);
-        else
-            acc -= 1;
+        const char *r = strchr(bench_ring_next(&st->ring), target);
+        BENCH_DO_NOT_OPTIMIZE(r);
         ops++;
     }
-    sink_int = acc;
     return ops;
 }
-static void cleanup_strchr(void *state)
-{
-    strchr_state *st = (strchr_state *)state;
-    free(st->s);
-    free(st);
-}
 
 /* 6. memcmp */
 typedef struct
 {
-    unsigned char *a, *b;
+    bench_ring ring; /* each slot: a, then b */
     size_t len;
 } memcmp_state;
 static void init_memcmp(void **state)
 {
     memcmp_state *st = xmalloc(sizeof(*st));
     st->len = 8192;
-    st->a = xmalloc(st->len);
-    st->b = xmalloc(st->len);
+    unsigned char *tmpl = xmalloc(2 * st->len);
     for (size_t i = 0; i < st->len; i++)
     {
-        st->a[i] = (unsigned char)(i & 0xFF);
-        st->b[i] = st->a[i];
+        tmpl[i] = (unsigned char)(i & 0xFF);
+        tmpl[st->len + i] = tmpl[i];
     }
+    bench_ring_init(&st->ring, tmpl, 2 * st->len);
+    free(tmpl);
     *state = st;
 }
 static size_t run_memcmp(void *state, size_t iters)
@@ -268,34 +207,30 @@ static size_t run_memcmp(void *state, size_t iters)
     size_t ops = 0;
     for (size_t i = 0; i < iters; i++)
     {
-        int r = memcmp(st->a, st->b, st->len);
-        sink_int = r;
+        unsigned char *a = bench_ring_next(&st->ring);
+        int r = memcmp(a, a + st->len, st->len);
+        BENCH_DO_NOT_OPTIMIZE(r);
         ops++;
     }
     return ops;
 }
-static void cleanup_memcmp(void *state)
-{
-    memcmp_state *st = (memcmp_state *)state;
-    free(st->a);
-    free(st->b);
-    free(st);
-}
 
 /* 7. memcpy */
 typedef struct
 {
-    unsigned char *src, *dst;
+    bench_ring ring; /* each slot: src, then dst */
     size_t len;
 } memcpy_state;
 static void init_memcpy(void **state)
 {
     memcpy_state *st = xmalloc(sizeof(*st));
     st->len = 16384;
-    st->src = xmalloc(st->len);
-    st->dst = xmalloc(st->len);
+    unsigned char *tmpl = xmalloc(2 * st->len);
     for (size_t i = 0; i < st->len; i++)
-        st->src[i] = (unsigned char)(rand());
+        tmpl[i] = (unsigned char)(rand());
+    memset(tmpl + st->len, 0, st->len);
+    bench_ring_init(&st->ring, tmpl, 2 * st->len);
+    free(tmpl);
     *state = st;
 }
 static size_t run_memcpy(void *state, size_t iters)
@@ -304,24 +239,18 @@ static size_t run_memcpy(void *state, size_t iters)
     size_t ops = 0;
     for (size_t i = 0; i < iters; i++)
     {
-        void *r = memcpy(st->dst, st->src, st->len);
-        sink_ptr = r;
+        unsigned char *src = bench_ring_next(&st->ring);
+        void *r = memcpy(src + st->len, src, st->len);
+        BENCH_DO_NOT_OPTIMIZE(r);
         ops++;
     }
     return ops;
 }
-static void cleanup_memcpy(void *state)
-{
-    memcpy_state *st = (memcpy_state *)state;
-    free(st->src);
-    free(st->dst);
-    free(st);
-}
 
 /* 8. memmove (overlap) */
 typedef struct
 {
-    unsigned char *buf;
+    bench_ring ring;
     size_t len;
     size_t shift;
 } memmove_state;
@@ -329,9 +258,11 @@ static void init_memmove(void **state)
 {
     memmove_state *st = xmalloc(sizeof(*st));
     st->len = 16384;
-    st->buf = xmalloc(st->len + 64);
+    unsigned char *tmpl = xmalloc(st->len + 64);
     for (size_t i = 0; i < st->len + 64; i++)
-        st->buf[i] = (unsigned char)i;
+        tmpl[i] = (unsigned char)i;
+    bench_ring_init(&st->ring, tmpl, st->len + 64);
+    free(tmpl);
     st->shift = 32;
     *state = st;
 }
@@ -341,18 +272,13 @@ static size_t run_memmove(void *state, size_t iters)
     size_t ops = 0;
     for (size_t i = 0; i < iters; i++)
     {
-        void *r = memmove(st->buf + st->shift, st->buf, st->len);
-        sink_ptr = r;
+        unsigned char *buf = bench_ring_next(&st->ring);
+        void *r = memmove(buf + st->shift, buf, st->len);
+        BENCH_DO_NOT_OPTIMIZE(r);
         ops++;
     }
     return ops;
 }
-static void cleanup_memmove(void *state)
-{
-    memmove_state *st = (memmove_state *)state;
-    free(st->buf);
-    free(st);
-}
 
 /* 9. qsort */
 typedef struct
@@ -385,7 +311,7 @@ static size_t run_qsort(void *state, size_t iters)
     {
         memcpy(st->work, st->orig, st->n * sizeof(int));
         qsort(st->work, st->n, sizeof(int), qsort_cmp_int);
-        sink_int = st->work[st->n / 2];
+        BENCH_DO_NOT_OPTIMIZE(st->work[st->n / 2]);
         ops++;
     }
     return ops;
@@ -428,7 +354,7 @@ static size_t run_bsearch(void *state, size_t iters)
         for (size_t k = 0; k < st->k; k++)
         {
             void *r = bsearch(&st->keys[k], st->arr, st->n, sizeof(int), qsort_cmp_int);
-            sink_ptr = r;
+            BENCH_DO_NOT_OPTIMIZE(r);
             ops++;
         }
     }
@@ -453,6 +379,7 @@ static size_t run_malloc_small(void *state, size_t iters)
         for (int k = 0; k < 256; k++)
         {
             ptrs[k] = xmalloc(32);
+            BENCH_DO_NOT_OPTIMIZE(ptrs[k]);
             ops++;
         }
         for (int k = 0; k < 256; k++)
@@ -460,6 +387,36 @@ static size_t run_malloc_small(void *state, size_t iters)
     }
     return ops;
 }
+/* Times each malloc and each free of a batch of `count` blocks */
+static size_t lat_malloc_batch(bench_hist *h, size_t iters, void **ptrs, int count, size_t size)
+{
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        for (int k = 0; k < count; k++)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            ptrs[k] = malloc(size);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            BENCH_DO_NOT_OPTIMIZE(ptrs[k]);
+            ops++;
+        }
+        for (int k = 0; k < count; k++)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            free(ptrs[k]);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            ops++;
+        }
+    }
+    return ops;
+}
+static size_t lat_malloc_small(void *state, size_t iters, bench_hist *h)
+{
+    (void)state;
+    void *ptrs[256];
+    return lat_malloc_batch(h, iters, ptrs, 256, 32);
+}
 
 /* 12. malloc/free medium */
 static size_t run_malloc_medium(void *state, size_t iters)
@@ -472,6 +429,7 @@ static size_t run_malloc_medium(void *state, size_t iters)
         for (int k = 0; k < 64; k++)
         {
             ptrs[k] = xmalloc(4096);
+            BENCH_DO_NOT_OPTIMIZE(ptrs[k]);
             ops++;
         }
         for (int k = 0; k < 64; k++)
@@ -479,6 +437,12 @@ static size_t run_malloc_medium(void *state, size_t iters)
     }
     return ops;
 }
+static size_t lat_malloc_medium(void *state, size_t iters, bench_hist *h)
+{
+    (void)state;
+    void *ptrs[64];
+    return lat_malloc_batch(h, iters, ptrs, 64, 4096);
+}
 
 /* 13. realloc pattern */
 static size_t run_realloc_pattern(void *state, size_t iters)
@@ -499,6 +463,31 @@ static size_t run_realloc_pattern(void *state, size_t iters)
                 break;
             }
             p = np;
+            BENCH_DO_NOT_OPTIMIZE(p);
+            ops++;
+        }
+        free(p);
+    }
+    return ops;
+}
+static size_t lat_realloc_pattern(void *state, size_t iters, bench_hist *h)
+{
+    (void)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t sz = 16;
+        char *p = xmalloc(sz);
+        for (int r = 0; r < 64; r++)
+        {
+            sz = (sz < 1024) ? sz * 2 : 16;
+            uint64_t t0 = bench_tsc_begin();
+            char *np = realloc(p, sz);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            if (!np)
+                break;
+            p = np;
+            BENCH_DO_NOT_OPTIMIZE(p);
             ops++;
         }
         free(p);
@@ -532,7 +521,7 @@ static size_t run_sprintf_int(void *state, size_t iters)
         for (size_t k = 0; k < st->n; k++)
         {
             int n = sprintf(st->buf, "%d", st->vals[k]);
-            sink_int = n;
+            BENCH_DO_NOT_OPTIMIZE(n);
             ops++;
         }
     }
@@ -572,7 +561,7 @@ static size_t run_sprintf_float(void *state, size_t iters)
         for (size_t k = 0; k < st->n; k++)
         {
             int n = sprintf(st->buf, "%.6f", st->vals[k]);
-            sink_int = n;
+            BENCH_DO_NOT_OPTIMIZE(n);
             ops++;
         }
     }
@@ -617,7 +606,24 @@ static size_t run_snprintf(void *state, size_t iters)
         for (size_t k = 0; k < st->n; k++)
         {
             int n = snprintf(st->buf, 256, "idx=%zu iv=%d dv=%.4f hex=%x", k, st->ivals[k], st->dvals[k], st->ivals[k]);
-            sink_int = n;
+            BENCH_DO_NOT_OPTIMIZE(n);
+            ops++;
+        }
+    }
+    return ops;
+}
+static size_t lat_snprintf(void *state, size_t iters, bench_hist *h)
+{
+    snprintf_state *st = (snprintf_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        for (size_t k = 0; k < st->n; k++)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            int n = snprintf(st->buf, 256, "idx=%zu iv=%d dv=%.4f hex=%x", k, st->ivals[k], st->dvals[k], st->ivals[k]);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            BENCH_DO_NOT_OPTIMIZE(n);
             ops++;
         }
     }
@@ -661,7 +667,7 @@ static size_t run_strtod(void *state, size_t iters)
         {
             char *end;
             double v = strtod(st->nums[k], &end);
-            sink_double = v;
+            BENCH_DO_NOT_OPTIMIZE(v);
             ops++;
         }
     }
@@ -706,7 +712,7 @@ static size_t run_strtok(void *state, size_t iters)
         char *tok = strtok(buf, ",");
         while (tok)
         {
-            sink_ptr = tok;
+            BENCH_DO_NOT_OPTIMIZE(tok);
             ops++;
             tok = strtok(NULL, ",");
         }
@@ -756,7 +762,24 @@ static size_t run_regex(void *state, size_t iters)
         for (size_t k = 0; k < st->n; k++)
         {
             int r = regexec(&st->rx, st->lines[k], 0, NULL, 0);
-            sink_int = r;
+            BENCH_DO_NOT_OPTIMIZE(r);
+            ops++;
+        }
+    }
+    return ops;
+}
+static size_t lat_regex(void *state, size_t iters, bench_hist *h)
+{
+    regex_state *st = (regex_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        for (size_t k = 0; k < st->n; k++)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            int r = regexec(&st->rx, st->lines[k], 0, NULL, 0);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            BENCH_DO_NOT_OPTIMIZE(r);
             ops++;
         }
     }
@@ -800,7 +823,7 @@ static size_t run_atoi(void *state, size_t iters)
         for (size_t k = 0; k < st->n; k++)
         {
             int v = atoi(st->nums[k]);
-            sink_int = v;
+            BENCH_DO_NOT_OPTIMIZE(v);
             ops++;
         }
     }
@@ -818,7 +841,7 @@ static void cleanup_atoi(void *state)
 /* 21. strstr */
 typedef struct
 {
-    char *haystack;
+    bench_ring ring; /* haystack copies */
     char **needles;
     size_t n;
 } strstr_state;
@@ -827,13 +850,13 @@ static void init_strstr(void **state)
 {
     strstr_state *st = xmalloc(sizeof(*st));
     size_t hlen = 65536;
-    st->haystack = xmalloc(hlen + 1);
+    char *haystack = xmalloc(hlen + 1);
     /* Build haystack: repeating pattern segments with some markers */
     const char *segment = "lorem_ipsum_dolor_sit_amet_consectetur_";
     size_t seglen = strlen(segment);
     for (size_t i = 0; i < hlen; i++)
-        st->haystack[i] = segment[i % seglen];
-    st->haystack[hlen] = '\0';
+        haystack[i] = segment[i % seglen];
+    haystack[hlen] = '\0';
 
     /* Insert a few distinctive substrings at known positions */
     const char *markers[] = {"ALPHA_token_X", "BETA_token_Y", "GAMMA_token_Z"};
@@ -842,9 +865,11 @@ static void init_strstr(void **state)
     {
         size_t pos = (hlen / (mcount + 1)) * (m + 1);
         if (pos + strlen(markers[m]) < hlen)
-            strcpy(st->haystack + pos, markers[m]);
-        // memcpy(st->haystack + pos, markers[m], strlen(markers[m]));
+            strcpy(haystack + pos, markers[m]);
+        // memcpy(haystack + pos, markers[m], strlen(markers[m]));
     }
+    bench_ring_init(&st->ring, haystack, hlen + 1);
+    free(haystack);
 
     st->n = 16;
     st->needles = xmalloc(st->n * sizeof(char *));
@@ -874,8 +899,8 @@ static size_t run_strstr(void *state, size_t iters)
     {
         for (size_t k = 0; k < n; k++)
         {
-            char *p = strstr(st->haystack, st->needles[(i + k) % n]);
-            sink_ptr = p;
+            char *p = strstr(bench_ring_next(&st->ring), st->needles[(i + k) % n]);
+            BENCH_DO_NOT_OPTIMIZE(p);
             ops++;
         }
     }
@@ -888,7 +913,7 @@ static void cleanup_strstr(void *state)
     for (size_t i = 0; i < st->n; i++)
         free(st->needles[i]);
     free(st->needles);
-    free(st->haystack);
+    bench_ring_free(&st->ring);
     free(st);
 }
 
@@ -897,14 +922,17 @@ static void cleanup_strstr(void *state)
 /* 22. memset */
 typedef struct
 {
-    unsigned char *area;
+    bench_ring ring; /* each slot: the len-byte area */
     size_t len;
 } bench_memset_state;
 static void init_memset_bench(void **st)
 {
     bench_memset_state *s = xmalloc(sizeof *s);
     s->len = 1 << 15;
-    s->area = xmalloc(s->len);
+    unsigned char *tmpl = xmalloc(s->len);
+    memset(tmpl, 0, s->len);
+    bench_ring_init(&s->ring, tmpl, s->len);
+    free(tmpl);
     *st = s;
 }
 static size_t run_memset_bench(void *st, size_t loop)
@@ -914,18 +942,12 @@ static size_t run_memset_bench(void *st, size_t loop)
     for (size_t iter = 0; iter < loop; ++iter)
     {
         int v = (int)(iter & 0xFF);
-        memset(s->area, v, s->len);
-        sink_int = v;
+        memset(bench_ring_next(&s->ring), v, s->len);
+        BENCH_CLOBBER_MEMORY();
         ++count;
     }
     return count;
 }
-static void cleanup_memset_bench(void *st)
-{
-    bench_memset_state *s = (bench_memset_state *)st;
-    free(s->area);
-    free(s);
-}
 
 /* 23. memchr / memrchr (GNU) */
 typedef struct
@@ -950,7 +972,7 @@ static size_t run_memchr_bench(void *st, size_t loop)
     {
         unsigned char needle = (unsigned char)(iter & 0xFF);
         void *p = memchr(s->blk, needle, s->len);
-        sink_ptr = p;
+        BENCH_DO_NOT_OPTIMIZE(p);
         ++count;
     }
     return count;
@@ -963,7 +985,7 @@ static size_t run_memrchr_bench(void *st, size_t loop)
     {
         unsigned char needle = (unsigned char)((iter * 3) & 0xFF);
         void *p = memrchr(s->blk, needle, s->len);
-        sink_ptr = p;
+        BENCH_DO_NOT_OPTIMIZE(p);
         ++count;
     }
     return count;
@@ -978,17 +1000,19 @@ static void cleanup_memchr_bench(void *st)
 /* 24. strnlen */
 typedef struct
 {
-    char *txt;
+    bench_ring ring;
     size_t cap;
 } bench_strnlen_state;
 static void init_strnlen_bench(void **st)
 {
     bench_strnlen_state *s = xmalloc(sizeof *s);
     s->cap = 4096;
-    s->txt = xmalloc(s->cap);
+    char *txt = xmalloc(s->cap);
     for (size_t i = 0; i < s->cap - 1; i++)
-        s->txt[i] = (i % 97) ? 'a' + (i % 26) : '\0';
-    s->txt[s->cap - 1] = '\0';
+        txt[i] = (i % 97) ? 'a' + (i % 26) : '\0';
+    txt[s->cap - 1] = '\0';
+    bench_ring_init(&s->ring, txt, s->cap);
+    free(txt);
     *st = s;
 }
 static size_t run_strnlen_bench(void *st, size_t loop)
@@ -998,41 +1022,36 @@ static size_t run_strnlen_bench(void *st, size_t loop)
     for (size_t iter = 0; iter < loop; ++iter)
     {
         size_t lim = 16 + (iter % s->cap);
-        size_t L = strnlen(s->txt, lim);
-        sink_size = L;
+        size_t L = strnlen(bench_ring_next(&s->ring), lim);
+        BENCH_DO_NOT_OPTIMIZE(L);
         ++count;
     }
     return count;
 }
-static void cleanup_strnlen_bench(void *st)
-{
-    bench_strnlen_state *s = (bench_strnlen_state *)st;
-    free(s->txt);
-    free(s);
-}
 
 /* 25. strncmp */
 typedef struct
 {
-    char *a;
-    char *b;
+    bench_ring ring; /* each slot: a, then b at len + 1 */
     size_t len;
 } bench_strncmp_state;
 static void init_strncmp_bench(void **st)
 {
     bench_strncmp_state *s = xmalloc(sizeof *s);
     s->len = 2048;
-    s->a = xmalloc(s->len + 1);
-    s->b = xmalloc(s->len + 1);
+    char *a = xmalloc(2 * (s->len + 1));
+    char *b = a + s->len + 1;
     for (size_t i = 0; i < s->len; i++)
     {
         char c = 'a' + (i % 26);
-        s->a[i] = c;
-        s->b[i] = c;
+        a[i] = c;
+        b[i] = c;
     }
-    s->a[s->len] = '\0';
-    s->b[s->len] = '\0';
-    s->b[s->len / 2] = 'Z';
+    a[s->len] = '\0';
+    b[s->len] = '\0';
+    b[s->len / 2] = 'Z';
+    bench_ring_init(&s->ring, a, 2 * (s->len + 1));
+    free(a);
     *st = s;
 }
 static size_t run_strncmp_bench(void *st, size_t loop)
@@ -1042,36 +1061,36 @@ static size_t run_strncmp_bench(void *st, size_t loop)
     for (size_t iter = 0; iter < loop; ++iter)
     {
         size_t n = 8 + ((iter * 13) % (s->len));
-        int r = strncmp(s->a, s->b, n);
-        sink_int = r;
+        char *a = bench_ring_next(&s->ring);
+        int r = strncmp(a, a + s->len + 1, n);
+        BENCH_DO_NOT_OPTIMIZE(r);
         ++count;
     }
     return count;
 }
-static void cleanup_strncmp_bench(void *st)
-{
-    bench_strncmp_state *s = (bench_strncmp_state *)st;
-    free(s->a);
-    free(s->b);
-    free(s);
-}
 
 /* 26. strncpy */
 typedef struct
 {
-    char *src;
-    char *dst;
+    bench_ring src; /* len characters */
+    bench_ring dst; /* len + 16 bytes */
     size_t len;
 } bench_strncpy_state;
 static void init_strncpy_bench(void **st)
 {
     bench_strncpy_state *s = xmalloc(sizeof *s);
     s->len = 4096;
-    s->src = xmalloc(s->len + 1);
-    s->dst = xmalloc(s->len + 16);
+    char *src = xmalloc(s->len + 1);
     for (size_t i = 0; i < s->len; i++)
-        s->src[i] = 'A' + (i % 26);
-    s->src[s->len] = '\0';
+        src[i] = 'A' + (i % 26);
+    src[s->len] = '\0';
+    bench_ring_init(&s->src, src, s->len + 1);
+    memset(src, 0, s->len + 1);
+    char *dst = xmalloc(s->len + 16);
+    memset(dst, 0, s->len + 16);
+    bench_ring_init(&s->dst, dst, s->len + 16);
+    free(src);
+    free(dst);
     *st = s;
 }
 static size_t run_strncpy_bench(void *st, size_t loop)
@@ -1084,33 +1103,29 @@ static size_t run_strncpy_bench(void *st, size_t loop)
         size_t dst_cap = s->len + 16; /* allocated size of dst */
         if (n > dst_cap)
             n = dst_cap; /* clamp to avoid overflow & zero padding beyond allocation */
-        char *r = strncpy(s->dst, s->src, n);
-        sink_ptr = r;
+        const char *src = bench_ring_next(&s->src);
+        char *r = strncpy(bench_ring_next(&s->dst), src, n);
+        BENCH_DO_NOT_OPTIMIZE(r);
         ++count;
     }
     return count;
 }
-static void cleanup_strncpy_bench(void *st)
-{
-    bench_strncpy_state *s = (bench_strncpy_state *)st;
-    free(s->src);
-    free(s->dst);
-    free(s);
-}
 
 /* 27. strncat */
 typedef struct
 {
-    char *dst;
-    char *piece;
+    bench_ring ring; /* each slot: piece, then dst at 64 */
     size_t cap;
 } bench_strncat_state;
 static void init_strncat_bench(void **st)
 {
     bench_strncat_state *s = xmalloc(sizeof *s);
     s->cap = 8192;
-    s->dst = xmalloc(s->cap);
-    s->piece = strdup("segment_data_block_");
+    char *tmpl = xmalloc(64 + s->cap);
+    memset(tmpl, 0, 64 + s->cap);
+    strcpy(tmpl, "segment_data_block_");
+    bench_ring_init(&s->ring, tmpl, 64 + s->cap);
+    free(tmpl);
     *st = s;
 }
 static size_t run_strncat_bench(void *st, size_t loop)
@@ -1119,68 +1134,60 @@ static size_t run_strncat_bench(void *st, size_t loop)
     size_t count = 0;
     for (size_t iter = 0; iter < loop; ++iter)
     {
-        s->dst[0] = '\0';
+        char *piece = bench_ring_next(&s->ring);
+        char *dst = piece + 64;
+        dst[0] = '\0';
         for (int r = 0; r < 16; r++)
         {
-            strncat(s->dst, s->piece, 8 + (iter & 7));
+            BENCH_DO_NOT_OPTIMIZE(strncat(dst, piece, 8 + (iter & 7)));
             ++count;
         }
-        sink_size = strlen(s->dst);
+        BENCH_DO_NOT_OPTIMIZE(strlen(dst));
     }
     return count;
 }
-static void cleanup_strncat_bench(void *st)
-{
-    bench_strncat_state *s = (bench_strncat_state *)st;
-    free(s->dst);
-    free(s->piece);
-    free(s);
-}
 
 /* 28. strrchr */
 typedef struct
 {
-    char *text;
+    bench_ring ring;
+    size_t len;
 } bench_strrchr_state;
 static void init_strrchr_bench(void **st)
 {
     bench_strrchr_state *s = xmalloc(sizeof *s);
     size_t L = 10000;
-    s->text = xmalloc(L + 1);
+    char *text = xmalloc(L + 1);
     for (size_t i = 0; i < L; i++)
     {
-        s->text[i] = (i % 101) == 0 ? 'X' : 'a' + (i % 26);
+        text[i] = (i % 101) == 0 ? 'X' : 'a' + (i % 26);
     }
-    s->text[L] = '\0';
+    text[L] = '\0';
+    s->len = L;
+    bench_ring_init(&s->ring, text, L + 1);
+    free(text);
     *st = s;
 }
 static size_t run_strrchr_bench(void *st, size_t loop)
 {
     bench_strrchr_state *s = (bench_strrchr_state *)st;
     size_t count = 0;
-    size_t len = strlen(s->text);
+    size_t len = s->len;
     for (size_t iter = 0; iter < loop; ++iter)
     {
+        char *text = bench_ring_next(&s->ring);
         /* Mutate one character so the location of the last 'X' changes,
            preventing the optimizer from treating strrchr() as a pure/constant call. */
         size_t idx = (iter * 131u) % len;
-        char prev = s->text[idx];
-        s->text[idx] = (prev == 'X') ? ('a' + (char)(iter % 26)) : 'X';
+        char prev = text[idx];
+        text[idx] = (prev == 'X') ? ('a' + (char)(iter % 26)) : 'X';
 
-        char *p = strrchr(s->text, 'X');
-        /* Use the offset (accumulated into a volatile) so result is needed. */
-        if (p)
-            sink_size += (size_t)(p - s->text);
+        char *p = strrchr(text, 'X');
+        BENCH_DO_NOT_OPTIMIZE(p);
         ++count;
     }
     return count;
 }
-static void cleanup_strrchr_bench(void *st)
-{
-    bench_strrchr_state *s = (bench_strrchr_state *)st;
-    free(s->text);
-    free(s);
-}
 
 /* 29. strtok_r */
 typedef struct
@@ -1212,7 +1219,7 @@ static size_t run_strtok_r_bench(void *st, size_t loop)
         char *tok = strtok_r(buf, ",", &ctx);
         while (tok)
         {
-            sink_ptr = tok;
+            BENCH_DO_NOT_OPTIMIZE(tok);
             ++count;
             tok = strtok_r(NULL, ",", &ctx);
         }
@@ -1237,7 +1244,7 @@ static void init_file_io_bench(void **st)
 {
     bench_file_io_state *s = xmalloc(sizeof *s);
     s->len = 1 << 20;
-    s->data = xmalloc(s->len);
+    s->data = bench_alloc_large(s->len);
     for (size_t i = 0; i < s->len; i++)
         s->data[i] = (unsigned char)(i * 31);
     *st = s;
@@ -1255,17 +1262,42 @@ static size_t run_fwrite_fread_bench(void *st, size_t loop)
         size_t w = fwrite(s->data, 1, s->len, fp);
         fseek(fp, 0, SEEK_SET);
         size_t r = fread(tmp, 1, s->len, fp);
-        sink_size = w + r;
+        BENCH_DO_NOT_OPTIMIZE(w + r);
         fclose(fp);
         ++count;
     }
     free(tmp);
     return count;
 }
+/* One sample per fwrite and per fread of the 1 MiB block */
+static size_t lat_fwrite_fread_bench(void *st, size_t loop, bench_hist *h)
+{
+    bench_file_io_state *s = (bench_file_io_state *)st;
+    size_t count = 0;
+    unsigned char *tmp = xmalloc(s->len);
+    for (size_t iter = 0; iter < loop; ++iter)
+    {
+        FILE *fp = tmpfile();
+        if (!fp)
+            break;
+        uint64_t t0 = bench_tsc_begin();
+        size_t w = fwrite(s->data, 1, s->len, fp);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        fseek(fp, 0, SEEK_SET);
+        t0 = bench_tsc_begin();
+        size_t r = fread(tmp, 1, s->len, fp);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(w + r);
+        fclose(fp);
+        count += 2;
+    }
+    free(tmp);
+    return count;
+}
 static void cleanup_file_io_bench(void *st)
 {
     bench_file_io_state *s = (bench_file_io_state *)st;
-    free(s->data);
+    bench_free_large(s->data, s->len);
     free(s);
 }
 
@@ -1302,7 +1334,31 @@ static size_t run_fgets_bench(void *st, size_t loop)
             break;
         while (fgets(buf, sizeof buf, fp))
         {
-            sink_int += (int)buf[0];
+            BENCH_DO_NOT_OPTIMIZE(buf[0]);
+            ++count;
+        }
+        fclose(fp);
+    }
+    return count;
+}
+static size_t lat_fgets_bench(void *st, size_t loop, bench_hist *h)
+{
+    bench_line_in_state *s = (bench_line_in_state *)st;
+    size_t count = 0;
+    char buf[128];
+    for (size_t iter = 0; iter < loop; ++iter)
+    {
+        FILE *fp = fmemopen(s->big, s->sz, "r");
+        if (!fp)
+            break;
+        for (;;)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            char *line = fgets(buf, sizeof buf, fp);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            if (!line)
+                break;
+            BENCH_DO_NOT_OPTIMIZE(buf[0]);
             ++count;
         }
         fclose(fp);
@@ -1323,7 +1379,34 @@ static size_t run_getline_bench(void *st, size_t loop)
         size_t n = 0;
         while (getline(&line, &n, fp) > 0)
         {
-            sink_int += (int)line[0];
+            BENCH_DO_NOT_OPTIMIZE(line[0]);
+            ++count;
+        }
+        free(line);
+        fclose(fp);
+    }
+    return count;
+}
+static size_t lat_getline_bench(void *st, size_t loop, bench_hist *h)
+{
+    bench_line_in_state *s = (bench_line_in_state *)st;
+    size_t count = 0;
+
+    for (size_t iter = 0; iter < loop; ++iter)
+    {
+        FILE *fp = fmemopen(s->big, s->sz, "r");
+        if (!fp)
+            break;
+        char *line = NULL;
+        size_t n = 0;
+        for (;;)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            ssize_t len = getline(&line, &n, fp);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            if (len <= 0)
+                break;
+            BENCH_DO_NOT_OPTIMIZE(line[0]);
             ++count;
         }
         free(line);
@@ -1365,7 +1448,7 @@ static size_t run_vsnprintf_bench(void *st, size_t loop)
     {
         int r = helper_vsnp(s->buf, 512, "val=%d hex=%x str=%s dbl=%.3f",
                             (int)iter, (unsigned)(iter * 17), "token", (double)iter / 3.0);
-        sink_int = r;
+        BENCH_DO_NOT_OPTIMIZE(r);
         ++count;
     }
     return count;
@@ -1378,7 +1461,7 @@ static size_t run_vprintf_bench(void *st, size_t loop)
     {
         int r = helper_vsnp(s->buf, 512, "A:%d B:%u C:%ld D:%0.2f",
                             (int)iter, (unsigned)iter, (long)(iter * iter), (double)iter / 7.0);
-        sink_int = r;
+        BENCH_DO_NOT_OPTIMIZE(r);
         ++count;
     }
     return count;
@@ -1390,115 +1473,124 @@ static void cleanup_vprintf_bench(void *st)
     free(s);
 }
 
+/* 33. libc call overhead: PLT/IFUNC vs. function pointer vs. local call */
+typedef struct
+{
+    char *s;
+    size_t (*fn)(const char *);
+} bench_call_state;
+#if defined(_MSC_VER)
+__declspec(noinline)
+#elif defined(__GNUC__) || defined(__clang__)
+__attribute__((noinline))
+#endif
+static size_t local_strlen(const char *s)
+{
+    size_t n = 0;
+    while (s[n])
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        /* Keep the compiler from turning the loop back into a strlen call. */
+        __asm__ volatile("");
+#endif
+        n++;
+    }
+    return n;
+}
+static void init_call_bench(void **st)
+{
+    bench_call_state *s = xmalloc(sizeof *s);
+    s->s = strdup("x");
+    /* volatile read so the indirect call is not devirtualized */
+    size_t (*volatile fn)(const char *) = strlen;
+    s->fn = fn;
+    *st = s;
+}
+static size_t run_call_plt_bench(void *st, size_t loop)
+{
+    bench_call_state *s = (bench_call_state *)st;
+    size_t count = 0;
+    for (size_t iter = 0; iter < loop; ++iter)
+    {
+        BENCH_DO_NOT_OPTIMIZE(strlen(s->s));
+        ++count;
+    }
+    return count;
+}
+static size_t run_call_fnptr_bench(void *st, size_t loop)
+{
+    bench_call_state *s = (bench_call_state *)st;
+    size_t count = 0;
+    for (size_t iter = 0; iter < loop; ++iter)
+    {
+        BENCH_DO_NOT_OPTIMIZE(s->fn(s->s));
+        ++count;
+    }
+    return count;
+}
+static size_t run_call_local_bench(void *st, size_t loop)
+{
+    bench_call_state *s = (bench_call_state *)st;
+    size_t count = 0;
+    for (size_t iter = 0; iter < loop; ++iter)
+    {
+        BENCH_DO_NOT_OPTIMIZE(local_strlen(s->s));
+        ++count;
+    }
+    return count;
+}
+static void cleanup_call_bench(void *st)
+{
+    bench_call_state *s = (bench_call_state *)st;
+    free(s->s);
+    free(s);
+}
+
 /* Benchmark registry */
-static Benchmark benchmarks[] = {
-    {"strlen", init_strlen, run_strlen, cleanup_free},
-    {"strcmp", init_strcmp, run_strcmp, cleanup_strcmp},
-    {"strcpy", init_strcpy, run_strcpy, cleanup_strcpy},
-    {"strcat", init_strcat, run_strcat, cleanup_strcat},
-    {"strchr", init_strchr, run_strchr, cleanup_strchr},
-    {"memcmp", init_memcmp, run_memcmp, cleanup_memcmp},
-    {"memcpy", init_memcpy, run_memcpy, cleanup_memcpy},
-    {"memmove", init_memmove, run_memmove, cleanup_memmove},
+static const Benchmark benchmarks[] = {
+    {"strlen", init_strlen, run_strlen, cleanup_ring, BENCH_F_CACHE, .bytes = 1024},
+    {"strcmp", init_strcmp, run_strcmp, cleanup_ring, BENCH_F_CACHE, .bytes = 110},
+    {"strcpy", init_strcpy, run_strcpy, cleanup_ring, BENCH_F_CACHE, .bytes = 4096},
+    {"strcat", init_strcat, run_strcat, cleanup_ring_pair, BENCH_F_CACHE, .bytes = 32},
+    {"strchr", init_strchr, run_strchr, cleanup_ring, BENCH_F_CACHE},
+    {"memcmp", init_memcmp, run_memcmp, cleanup_ring, BENCH_F_CACHE, .bytes = 16384},
+    {"memcpy", init_memcpy, run_memcpy, cleanup_ring, BENCH_F_CACHE, .bytes = 32768},
+    {"memmove", init_memmove, run_memmove, cleanup_ring, BENCH_F_CACHE, .bytes = 32768},
+    {"memset", init_memset_bench, run_memset_bench, cleanup_ring, BENCH_F_CACHE, .bytes = 32768},
     {"qsort_int", init_qsort, run_qsort, cleanup_qsort},
     {"bsearch_int", init_bsearch, run_bsearch, cleanup_bsearch},
-    {"malloc_free_small", NULL, run_malloc_small, NULL},
-    {"malloc_free_medium", NULL, run_malloc_medium, NULL},
-    {"realloc_pattern", NULL, run_realloc_pattern, NULL},
+    {"malloc_free_small", NULL, run_malloc_small, NULL, 0, lat_malloc_small},
+    {"malloc_free_medium", NULL, run_malloc_medium, NULL, 0, lat_malloc_medium},
+    {"realloc_pattern", NULL, run_realloc_pattern, NULL, 0, lat_realloc_pattern},
     {"sprintf_int", init_sprintf_int, run_sprintf_int, cleanup_sprintf_int},
     {"sprintf_float", init_sprintf_float, run_sprintf_float, cleanup_sprintf_float},
-    {"snprintf_mix", init_snprintf, run_snprintf, cleanup_snprintf},
+    {"snprintf_mix", init_snprintf, run_snprintf, cleanup_snprintf, 0, lat_snprintf},
     {"strtod_parse", init_strtod, run_strtod, cleanup_strtod},
-    {"strtok_parse", init_strtok, run_strtok, cleanup_strtok},
-    {"regex_match", init_regex, run_regex, cleanup_regex},
+    {"strtok_parse", init_strtok, run_strtok, cleanup_strtok, BENCH_F_NOT_MT},
+    {"regex_match", init_regex, run_regex, cleanup_regex, 0, lat_regex},
     {"atoi_parse", init_atoi, run_atoi, cleanup_atoi},
-    {"strstr_search", init_strstr, run_strstr, cleanup_strstr},
-    {"strnlen", init_strnlen_bench, run_strnlen_bench, cleanup_strnlen_bench},
-    {"strncmp", init_strncmp_bench, run_strncmp_bench, cleanup_strncmp_bench},
-    {"strncpy", init_strncpy_bench, run_strncpy_bench, cleanup_strncpy_bench},
-    {"strncat", init_strncat_bench, run_strncat_bench, cleanup_strncat_bench},
-    {"strrchr", init_strrchr_bench, run_strrchr_bench, cleanup_strrchr_bench},
+    /* The first marker ends the haystack at 16397 bytes, and 6 of the 16
+       needles match within its first 44, so an op scans about 10 KiB */
+    {"strstr_search", init_strstr, run_strstr, cleanup_strstr, BENCH_F_CACHE, .bytes = 10240},
+    /* No .bytes: the text starts with a NUL, so strnlen stops at byte 0 */
+    {"strnlen", init_strnlen_bench, run_strnlen_bench, cleanup_ring, BENCH_F_CACHE},
+    {"strncmp", init_strncmp_bench, run_strncmp_bench, cleanup_ring, BENCH_F_CACHE, .bytes = 1024},
+    {"strncpy", init_strncpy_bench, run_strncpy_bench, cleanup_ring_pair, BENCH_F_CACHE, .bytes = 2048},
+    {"strncat", init_strncat_bench, run_strncat_bench, cleanup_ring, BENCH_F_CACHE, .bytes = 32},
+    {"strrchr", init_strrchr_bench, run_strrchr_bench, cleanup_ring, BENCH_F_CACHE, .bytes = 10000},
     {"strtok_r_parse", init_strtok_r_bench, run_strtok_r_bench, cleanup_strtok_r_bench},
-    {"file_io_rw", init_file_io_bench, run_fwrite_fread_bench, cleanup_file_io_bench},
-    {"fgets_read", init_line_in_bench, run_fgets_bench, cleanup_line_in_bench},
-    {"getline_read", init_line_in_bench, run_getline_bench, cleanup_line_in_bench},
+    {"file_io_rw", init_file_io_bench, run_fwrite_fread_bench, cleanup_file_io_bench, 0, lat_fwrite_fread_bench},
+    {"fgets_read", init_line_in_bench, run_fgets_bench, cleanup_line_in_bench, 0, lat_fgets_bench},
+    {"getline_read", init_line_in_bench, run_getline_bench, cleanup_line_in_bench, 0, lat_getline_bench},
     {"vsnprintf_mix", init_vprintf_bench, run_vsnprintf_bench, cleanup_vprintf_bench},
     {"vprintf_mix", init_vprintf_bench, run_vprintf_bench, cleanup_vprintf_bench},
+    {"call_plt_strlen", init_call_bench, run_call_plt_bench, cleanup_call_bench},
+    {"call_fnptr_strlen", init_call_bench, run_call_fnptr_bench, cleanup_call_bench},
+    {"call_local_strlen", init_call_bench, run_call_local_bench, cleanup_call_bench},
 };
-
-static void usage(const char *prog)
-{
-    fprintf(stderr, "Usage: %s [-t target_ms]\n", prog);
-}
+BENCH_REGISTER_TABLE(benchmarks)
 
 int main(int argc, char **argv)
 {
-    uint64_t target_ms = 250;
-    for (int i = 1; i < argc; i++)
-    {
-        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
-        {
-            target_ms = (uint64_t)strtoull(argv[++i], NULL, 10);
-        }
-        else
-        {
-            usage(argv[0]);
-            return 1;
-        }
-    }
-    uint64_t target_ns = target_ms * 1000000ull;
-
-    size_t count = sizeof(benchmarks) / sizeof(benchmarks[0]);
-    printf("benchmark,operations,time_ns,ns_per_op,ops_per_sec\n");
-
-    for (size_t i = 0; i < count; i++)
-    {
-        Benchmark *b = &benchmarks[i];
-        void *state = NULL;
-        if (b->init)
-            b->init(&state);
-
-        size_t iters = 1;
-        uint64_t elapsed_ns = 0;
-        size_t operations = 0;
-
-        /* Calibration loop */
-        while (1)
-        {
-            uint64_t start = now_ns();
-            operations = b->run(state, iters);
-            elapsed_ns = now_ns() - start;
-            if (elapsed_ns >= target_ns || iters > (1ull << 30) || elapsed_ns > target_ns / 4)
-                break;
-            iters *= 2;
-        }
-
-        /* If too short, scale proportionally */
-        if (elapsed_ns < target_ns / 2 && elapsed_ns > 0)
-        {
-            double scale = (double)target_ns / (double)elapsed_ns;
-            size_t new_iters = (size_t)((double)iters * scale);
-            if (new_iters > iters)
-            {
-                if (new_iters > iters * 8)
-                    new_iters = iters * 8;
-                uint64_t start = now_ns();
-                operations = b->run(state, new_iters);
-                elapsed_ns = now_ns() - start;
-                iters = new_iters;
-            }
-        }
-
-        double ns_per_op = operations ? (double)elapsed_ns / (double)operations : 0.0;
-
-        printf("%s,%llu,%llu,%.2f\n",
-               b->name,
-               (unsigned long long)operations,
-               (unsigned long long)elapsed_ns,
-               ns_per_op);
-
-        if (b->cleanup)
-            b->cleanup(state);
-    }
-    return 0;
-}
\ No newline at end of file
+    return bench_main(argc, argv);
+}
@@ -0,0 +1,138 @@
+"""
+Folded stacks and SVG flame graphs from `perf script`, for run.sh --profile
+when Brendan Gregg's FlameGraph scripts are not installed:
+
+    perf script -i perf.data | python flamegraph.py collapse > out.folded
+    python flamegraph.py svg "title" out.folded > out.svg
+
+collapse writes one "root;...;leaf count" line per distinct stack, the
+format of stackcollapse-perf.pl, so flamegraph.pl can read it too. svg draws
+a static flame graph: frames sorted by name, hover text from <title>.
+"""
+import html
+import re
+import sys
+import zlib
+
+WIDTH = 1200
+FRAME_HEIGHT = 16
+FONT_SIZE = 12
+CHAR_WIDTH = 0.59 * FONT_SIZE
+MIN_WIDTH = 0.1  # frames narrower than this (px) are dropped
+PAD_TOP = 40
+PAD_SIDE = 10
+
+# "    7f12 func+0x14 (/usr/lib/libc.so.6)"; symbol may be [unknown]
+FRAME_RE = re.compile(r"^\s*[0-9a-f]+\s+(.*?)(?:\+0x[0-9a-f]+)?\s+\((.*)\)\s*$")
+
+
+def frame_name(sym, dso):
+    if sym == "[unknown]":
+        return f"[{dso.rsplit('/', 1)[-1]}]"
+    return sym
+
+
+def collapse(lines):
+    """perf script samples -> {stack: count}, stack root first with the command as root."""
+    stacks = {}
+    comm, frames = None, []
+
+    def flush():
+        if comm is not None:
+            key = ";".join([comm] + frames[::-1])
+            stacks[key] = stacks.get(key, 0) + 1
+
+    for line in lines:
+        if not line.strip():
+            flush()
+            comm, frames = None, []
+        elif line[0] not in " \t":
+            flush()
+            comm, frames = line.split()[0], []
+        else:
+            m = FRAME_RE.match(line)
+            if m and comm is not None:
+                frames.append(frame_name(m.group(1), m.group(2)))
+    flush()
+    return stacks
+
+
+def build_tree(folded):
+    """Folded lines -> nested [name, value, children{}] tree."""
+    root = ["all", 0, {}]
+    for line in folded:
+        stack, _, count = line.rstrip().rpartition(" ")
+        if not stack or not count.isdigit():
+            continue
+        n = int(count)
+        node = root
+        node[1] += n
+        for name in stack.split(";"):
+            node = node[2].setdefault(name, [name, 0, {}])
+            node[1] += n
+    return root
+
+
+def color(name):
+    """Stable warm color per function name, as in flamegraph.pl's "hot" palette."""
+    h = zlib.crc32(name.encode())
+    return f"rgb({205 + h % 50},{(h >> 8) % 230},{(h >> 16) % 55})"
+
+
+def depth_of(node):
+    return 1 + max((depth_of(c) for c in node[2].values()), default=0)
+
+
+def render_svg(title, root):
+    total = root[1] or 1
+    scale = (WIDTH - 2 * PAD_SIDE) / total
+    height = depth_of(root) * FRAME_HEIGHT + PAD_TOP + 2 * PAD_SIDE
+    out = [
+        '<?xml version="1.0" standalone="no"?>',
+        f'<svg version="1.1" width="{WIDTH}" height="{height}" '
+        f'xmlns="http://www.w3.org/2000/svg" font-family="Verdana" font-size="{FONT_SIZE}">',
+        f'<rect x="0" y="0" width="{WIDTH}" height="{height}" fill="#f8f8f8"/>',
+        f'<text x="{WIDTH / 2}" y="24" text-anchor="middle" font-size="17">{html.escape(title)}</text>',
+    ]
+
+    def draw(node, x, depth):
+        w = node[1] * scale
+        if w < MIN_WIDTH:
+            return
+        y = height - PAD_SIDE - (depth + 1) * FRAME_HEIGHT
+        label = html.escape(node[0])
+        pct = 100.0 * node[1] / total
+        out.append(f'<g><title>{label} ({node[1]} samples, {pct:.2f}%)</title>'
+                   f'<rect x="{x:.1f}" y="{y}" width="{w:.1f}" height="{FRAME_HEIGHT - 1}" '
+                   f'fill="{color(node[0])}" rx="2"/>')
+        chars = int((w - 6) / CHAR_WIDTH)
+        if chars >= 3:
+            text = node[0] if len(node[0]) <= chars else node[0][:chars - 2] + ".."
+            out.append(f'<text x="{x + 3:.1f}" y="{y + FRAME_HEIGHT - 4}">{html.escape(text)}</text>')
+        out.append("</g>")
+        for name in sorted(node[2]):
+            child = node[2][name]
+            draw(child, x, depth + 1)
+            x += child[1] * scale
+
+    draw(root, PAD_SIDE, 0)
+    out.append("</svg>")
+    return "\n".join(out) + "\n"
+
+
+def main():
+    if len(sys.argv) == 2 and sys.argv[1] == "collapse":
+        for stack, count in sorted(collapse(sys.stdin).items()):
+            print(f"{stack} {count}")
+        return 0
+    if len(sys.argv) == 4 and sys.argv[1] == "svg":
+        with open(sys.argv[3], "r", encoding="utf-8") as f:
+            sys.stdout.write(render_svg(sys.argv[2], build_tree(f)))
+        return 0
+    print(f"Usage: {sys.argv[0]} collapse < perf-script.txt > out.folded\n"
+          f"       {sys.argv[0]} svg title out.folded > out.svg", file=sys.stderr)
+    return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,157 @@
+"""
+Footprint of one build cell, written by run.sh --footprint as
+results/matrix/<label>.footprint.csv (metric,value rows):
+
+    python footprint.py benchmark benchmark.full empty_main build_ms functions.txt
+
+- benchmark: the stripped binary that was measured; file and section sizes
+- benchmark.full: the same build without -s; file size and, for static
+  binaries, the libc functions linked in (.symtab)
+- empty_main: footprint/empty_main.c built with the cell's flags; file size
+  and the median startup RSS and page faults over STARTUP_RUNS runs
+- build_ms: wall time of the cell's build
+- functions.txt: receives the linked (static) or imported (dynamic) libc
+  function names, one per line
+
+ELF files are parsed directly, so binutils are not needed.
+"""
+import statistics
+import struct
+import subprocess
+import sys
+from pathlib import Path
+
+STARTUP_RUNS = 20
+
+SHT_SYMTAB = 2
+SHT_NOBITS = 8
+SHT_DYNSYM = 11
+SHF_WRITE = 0x1
+SHF_ALLOC = 0x2
+SHF_EXECINSTR = 0x4
+STT_FUNC = 2
+STT_GNU_IFUNC = 10
+STB_GLOBAL = 1
+STB_WEAK = 2
+
+# Global functions the benchmark itself defines
+OWN_PREFIXES = ("bench_", "__wrap_", "__real_", "plugin_")
+OWN_NAMES = {"main"}
+
+
+def read_sections(data):
+    """Returns [(name, type, flags, size, link, offset, entsize)] of an ELF64 LE file."""
+    if data[:4] != b"\x7fELF" or data[4] != 2 or data[5] != 1:
+        raise ValueError("not a little-endian ELF64 file")
+    shoff, = struct.unpack_from("<Q", data, 0x28)
+    shentsize, shnum, shstrndx = struct.unpack_from("<HHH", data, 0x3A)
+    raw = [struct.unpack_from("<IIQQQQIIQQ", data, shoff + i * shentsize) for i in range(shnum)]
+    names_off = raw[shstrndx][4]
+
+    def cstr(off):
+        return data[off:data.index(b"\0", off)].decode("ascii", "replace")
+
+    return [(cstr(names_off + s[0]), s[1], s[2], s[5], s[6], s[4], s[9]) for s in raw]
+
+
+def function_symbols(data, sections, table_type):
+    """(name, defined, value, size) of global/weak functions in a symbol table."""
+    out = []
+    for name, stype, _flags, size, link, offset, entsize in sections:
+        if stype != table_type or not entsize:
+            continue
+        strtab = sections[link][5]
+        for off in range(offset, offset + size, entsize):
+            st_name, info, _other, shndx, value, sym_size = struct.unpack_from("<IBBHQQ", data, off)
+            if info & 0xF not in (STT_FUNC, STT_GNU_IFUNC) or info >> 4 not in (STB_GLOBAL, STB_WEAK):
+                continue
+            end = data.index(b"\0", strtab + st_name)
+            out.append((data[strtab + st_name:end].decode("ascii", "replace"), shndx != 0, value, sym_size))
+    return out
+
+
+def libc_functions(stripped, full):
+    """(names, count, bytes) of libc functions; bytes is None for dynamic links."""
+    data = stripped.read_bytes()
+    sections = read_sections(data)
+    if any(s[0] == ".interp" for s in sections):
+        names = sorted({n for n, defined, _v, _s in function_symbols(data, sections, SHT_DYNSYM)
+                        if not defined})
+        return names, len(names), None
+    data = full.read_bytes()
+    sections = read_sections(data)
+    names, by_addr = set(), {}
+    for name, defined, value, size in function_symbols(data, sections, SHT_SYMTAB):
+        if not defined or name in OWN_NAMES or name.startswith(OWN_PREFIXES):
+            continue
+        names.add(name)
+        by_addr[value] = max(size, by_addr.get(value, 0))  # aliases share an address
+    return sorted(names), len(by_addr), sum(by_addr.values())
+
+
+def section_sizes(path):
+    """Per-section sizes of loaded sections plus text/rodata/data/bss totals."""
+    sizes, totals = {}, {"text": 0, "rodata": 0, "data": 0, "bss": 0}
+    for name, stype, flags, size, _link, _off, _ent in read_sections(path.read_bytes()):
+        if not flags & SHF_ALLOC or not name:
+            continue
+        sizes[name] = sizes.get(name, 0) + size
+        if flags & SHF_EXECINSTR:
+            totals["text"] += size
+        elif stype == SHT_NOBITS:
+            totals["bss"] += size
+        elif flags & SHF_WRITE:
+            totals["data"] += size
+        else:
+            totals["rodata"] += size
+    return sizes, totals
+
+
+def startup(path):
+    """Median peak RSS (KiB) and minor/major faults of a process that only starts up."""
+    hwm, minflt, majflt = [], [], []
+    for _ in range(STARTUP_RUNS):
+        out = subprocess.run([str(path.resolve())], capture_output=True, text=True,
+                             check=True, timeout=10).stdout.splitlines()
+        status = dict(ln.split(":", 1) for ln in out if ":" in ln)
+        hwm.append(int(status["VmHWM"].split()[0]))
+        # Fields after "(comm)": state is field 3, minflt 10, majflt 12
+        stat = out[-1].rsplit(")", 1)[1].split()
+        minflt.append(int(stat[7]))
+        majflt.append(int(stat[9]))
+    return statistics.median(hwm), statistics.median(minflt), statistics.median(majflt)
+
+
+def main():
+    if len(sys.argv) != 6:
+        print(f"Usage: {sys.argv[0]} benchmark benchmark.full empty_main build_ms functions.txt",
+              file=sys.stderr)
+        return 1
+    stripped, full, empty = Path(sys.argv[1]), Path(sys.argv[2]), Path(sys.argv[3])
+    rows = [
+        ("stripped_bytes", stripped.stat().st_size),
+        ("unstripped_bytes", full.stat().st_size),
+        ("build_ms", sys.argv[4] or "-"),
+    ]
+    sizes, totals = section_sizes(stripped)
+    rows += [(f"{kind}_bytes", size) for kind, size in totals.items()]
+    names, count, size = libc_functions(stripped, full)
+    Path(sys.argv[5]).write_text("".join(n + "\n" for n in names), encoding="utf-8")
+    rows.append(("libc_functions", count))
+    rows.append(("libc_function_bytes", "-" if size is None else size))
+    hwm, minflt, majflt = startup(empty)
+    rows += [
+        ("empty_main_bytes", empty.stat().st_size),
+        ("startup_rss_kib", f"{hwm:g}"),
+        ("startup_minflt", f"{minflt:g}"),
+        ("startup_majflt", f"{majflt:g}"),
+    ]
+    rows += [(f"section:{name}", size) for name, size in sorted(sizes.items())]
+    print("metric,value")
+    for key, value in rows:
+        print(f"{key},{value}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -2,11 +2,19 @@ from pathlib import Path
 import subprocess
 import platform
 import datetime
+import math
+import statistics
 
 RESULTS_DIR = Path("results")
 GNU_FILE = RESULTS_DIR / "benchmark-gnu.csv"
 MUSL_FILE = RESULTS_DIR / "benchmark-musl.csv"
 OUT_MD = Path("README.md")
+PROFILES_DIR = Path("profiles")
+MATRIX_DIR = RESULTS_DIR / "matrix"
+PROFILE_DIR = RESULTS_DIR / "profile"
+
+# Two-sided 95% normal quantile used for the profile confidence bounds.
+Z_95 = 1.959964
 
 
 def load(path):
@@ -16,7 +24,12 @@ def load(path):
       1) Old semicolon format (possibly prefixed with '1,')
       2) New comma CSV:
          - Header: benchmark,operations,time_ns,ns_per_op[,ops_per_sec]
+           [,samples,ns_per_op_sd][,rse_pct][,bytes_per_cycle,suspect][,metrics]
          - Data lines may omit ops_per_sec (will be computed)
+         - samples/ns_per_op_sd default to a single sample with no spread
+         - rse_pct is the relative standard error the harness reached
+         - suspect marks rows the harness found implausibly fast
+         - metrics holds extra name=value pairs separated by ';'
     """
     data = {}
     if not path.exists():
@@ -76,6 +89,15 @@ def load(path):
         time_ns = parse_number(get(parts, "time_ns"))
         ns_per_op = parse_number(get(parts, "ns_per_op"))
         ops_per_sec = parse_number(get(parts, "ops_per_sec"))
+        samples = parse_number(get(parts, "samples"))
+        ns_per_op_sd = parse_number(get(parts, "ns_per_op_sd"))
+        rse_pct = parse_number(get(parts, "rse_pct"))
+        suspect = parse_number(get(parts, "suspect"))
+        metrics = {}
+        for pair in (get(parts, "metrics") or "").split(";"):
+            key, _, value = pair.partition("=")
+            if key and parse_number(value) is not None:
+                metrics[key] = float(value)
 
         # Derive missing metrics
         if ns_per_op is None and operations and time_ns and operations != 0:
@@ -96,6 +118,11 @@ def load(path):
             "time_ns": time_ns if time_ns is not None else 0,
             "ns_per_op": float(ns_per_op),
             "ops_per_sec": float(ops_per_sec),
+            "samples": int(samples) if samples else 1,
+            "ns_per_op_sd": float(ns_per_op_sd) if ns_per_op_sd else 0.0,
+            "rse_pct": float(rse_pct) if rse_pct is not None else None,
+            "suspect": bool(suspect),
+            "metrics": metrics,
         }
     return data
 
@@ -114,11 +141,605 @@ def percent_diff(a, b, lower_is_better=True):
         return (b - a) / a * 100.0
 
 
+def load_rows(path):
+    """
+    Generic CSV loader for the non-throughput outputs (e.g. latency mode):
+    returns dict benchmark -> {column: float} for every numeric column.
+    """
+    data = {}
+    if not path.exists():
+        return data
+    with path.open("r", encoding="utf-8") as f:
+        rows = [ln.strip().split(",") for ln in f if ln.strip()]
+    if not rows or "benchmark" not in rows[0]:
+        return data
+    header = rows[0]
+    for row in rows[1:]:
+        entry = {}
+        for key, value in zip(header, row):
+            try:
+                entry[key] = float(value)
+            except ValueError:
+                entry[key] = value
+        data[entry["benchmark"]] = entry
+    return data
+
+
+def render_latency(gnu_lat, musl_lat):
+    """Per-call latency percentiles (benchmark -L) for both libcs."""
+    lines = ["### Per-call latency\n"]
+    lines.append(
+        "Individual calls timed with serialized rdtsc/rdtscp, timer overhead "
+        "subtracted (`run.sh --latency`, benchmark `-L`); ns.")
+    lines.append("")
+    lines.append("| Benchmark | glibc p50 | glibc p99 | glibc p99.9 | glibc max "
+                 "| musl p50 | musl p99 | musl p99.9 | musl max |")
+    lines.append("|---|---|---|---|---|---|---|---|---|")
+    for name in sorted(set(gnu_lat) | set(musl_lat)):
+        row = [name]
+        for lat in (gnu_lat, musl_lat):
+            r = lat.get(name)
+            for key in ("p50_ns", "p99_ns", "p999_ns", "max_ns"):
+                row.append(f"{r[key]:.1f}" if r else "-")
+        lines.append("| " + " | ".join(row) + " |")
+    return lines
+
+
+def render_applications(gnu, musl):
+    """Composite app_* workloads as records per second."""
+    names = sorted(n for n in set(gnu) & set(musl) if n.startswith("app_"))
+    if not names:
+        return []
+    lines = ["", "### Application workloads\n"]
+    lines.append(
+        "Composite per-record workloads built from libc calls only "
+        "(`kernels/app.c`); records/s, higher is better.")
+    lines.append("")
+    lines.append("| Workload | glibc records/s | musl records/s | musl vs glibc |")
+    lines.append("|---|---|---|---|")
+    log_sum = 0.0
+    for name in names:
+        g, m = gnu[name]["ops_per_sec"], musl[name]["ops_per_sec"]
+        rel = f"{(m / g - 1.0) * 100.0:+.2f}%" if g > 0 else "-"
+        if g > 0 and m > 0:
+            log_sum += math.log(m / g)
+        lines.append(f"| {name[4:]} | {g:.0f} | {m:.0f} | {rel} |")
+    lines.append("")
+    lines.append(
+        f"Geometric mean, musl vs glibc: {(math.exp(log_sum / len(names)) - 1.0) * 100.0:+.2f}% records/s")
+    return lines
+
+
+# libc row -> (reference kind, size tag) it is measured against
+ROOFLINE_ROWS = [("memcpy", "copy", "16k"), ("memmove", "copy", "16k"), ("memset", "set", "32k")] + [
+    (f"{fn}_big_{size}", "set" if fn == "memset" else "copy", size)
+    for size in ("256k", "4m", "64m") for fn in ("memcpy", "memset", "memmove")]
+
+
+def best_reference(results, kind, size):
+    """Fastest non-suspect ref_<kind>_<impl>_<size> row as (impl, ns/op)."""
+    best = None
+    for name, r in results.items():
+        parts = name.split("_")
+        if (len(parts) != 4 or parts[0] != "ref" or parts[1] != kind
+                or parts[3] != size or r["suspect"] or r["ns_per_op"] <= 0):
+            continue
+        if best is None or r["ns_per_op"] < best[1]:
+            best = (parts[2], r["ns_per_op"])
+    return best
+
+
+def render_roofline(gnu, musl):
+    """libc memcpy/memset/memmove as a percentage of the best reference loop."""
+    rows = []
+    for name, kind, size in ROOFLINE_ROWS:
+        row = [name, size]
+        found = False
+        for results in (gnu, musl):
+            r, best = results.get(name), best_reference(results, kind, size)
+            if r and best and r["ns_per_op"] > 0:
+                found = True
+                row.append(f"{r['ns_per_op']:.2f}")
+                row.append(f"{best[1] / r['ns_per_op'] * 100.0:.0f}% ({best[0]})")
+            else:
+                row.extend(["-", "-"])
+        if found:
+            rows.append("| " + " | ".join(row) + " |")
+    if not rows:
+        return []
+    lines = ["", "### Roofline\n"]
+    lines.append(
+        "Each libc row as a percentage of the fastest reference loop of the same "
+        "size in the same run (`kernels/roofline.c`: SSE2/AVX2/AVX-512 loops and "
+        "`rep movsb`/`rep stosb`, whichever the CPU supports), with that reference "
+        "in parentheses. 100% matches the best plain loop; above 100% beats it. "
+        "`memmove_big_*` shifts within one buffer, half the footprint of the "
+        "reference copy, so it can pass 100% once the copy spills a cache level.")
+    lines.append("")
+    lines.append("| Function | Size | glibc ns/op | glibc % of best | musl ns/op | musl % of best |")
+    lines.append("|---|---|---|---|---|---|")
+    lines.extend(rows)
+    return lines
+
+
+SORT_ALGOS = ("qsort", "qsort_r", "introsort_cb", "introsort", "radix")
+
+
+def render_sorting(gnu, musl):
+    """sort_* rows relative to the inlined introsort of the same size."""
+    sizes = sorted({n.rsplit("_", 1)[1] for n in set(gnu) | set(musl)
+                    if n.startswith("sort_introsort_") and not n.startswith("sort_introsort_cb_")},
+                   key=lambda t: int(t[:-1]))
+    if not sizes:
+        return []
+    lines = ["", "### Sorting\n"]
+    lines.append(
+        "The same random ints through libc qsort/qsort_r and the sorts in "
+        "`kernels/sort.c`, as ns per sort and as a multiple of the introsort with "
+        "the comparison inlined. qsort vs introsort_cb is the libc's algorithm "
+        "(both call the comparator through a pointer); introsort_cb vs introsort "
+        "is the callback.")
+    lines.append("")
+    lines.append("| Sort | n | glibc ns/sort | glibc vs introsort | musl ns/sort | musl vs introsort |")
+    lines.append("|---|---|---|---|---|---|")
+    for size in sizes:
+        for algo in SORT_ALGOS:
+            row = [algo, size]
+            for results in (gnu, musl):
+                r, base = results.get(f"sort_{algo}_{size}"), results.get(f"sort_introsort_{size}")
+                row.append(f"{r['ns_per_op']:.0f}" if r else "-")
+                row.append(f"{r['ns_per_op'] / base['ns_per_op']:.2f}x"
+                           if r and base and base["ns_per_op"] > 0 else "-")
+            lines.append("| " + " | ".join(row) + " |")
+    return lines
+
+
+STREAM_METHODS = ("fgets", "getline", "getdelim", "fread_memchr", "mmap_memchr")
+
+
+def render_streaming(gnu_s, musl_s):
+    """stream_* rows of the -S pass as GB/s and peak RSS per libc."""
+    lines = ["### Streaming corpus\n"]
+    first = next(iter(gnu_s.values() or musl_s.values()))
+    size = first["metrics"].get("corpus_bytes", 0.0)
+    lines.append(
+        f"One pass over a generated {size / 2**20:.0f} MiB access log in a "
+        "temporary file, split into lines by each method (`run.sh --stream`, "
+        "benchmark `-S`). Peak RSS is the largest resident set at the end of a "
+        "pass; the mapped file counts towards it for mmap.")
+    lines.append("")
+    lines.append("| Method | glibc GB/s | glibc peak RSS (MiB) | musl GB/s | musl peak RSS (MiB) "
+                 "| musl vs glibc (GB/s) |")
+    lines.append("|---|---|---|---|---|---|")
+    for method in STREAM_METHODS:
+        name = f"stream_{method}"
+        row, rates = [method], []
+        for results in (gnu_s, musl_s):
+            r = results.get(name)
+            corpus = r["metrics"].get("corpus_bytes") if r else None
+            rate = corpus / r["ns_per_op"] if corpus and r["ns_per_op"] > 0 else None
+            rates.append(rate)
+            row.append(f"{rate:.2f}" if rate else "-")
+            rss = r["metrics"].get("peak_rss_mib") if r else None
+            row.append(f"{rss:.1f}" if rss is not None else "-")
+        g, m = rates
+        row.append(f"{(m / g - 1.0) * 100.0:+.2f}%" if g and m else "-")
+        lines.append("| " + " | ".join(row) + " |")
+    return lines
+
+
+def render_concurrent(gnu_mt, musl_mt):
+    """Whole-registry concurrent pass (benchmark -j) for both libcs."""
+    threads = next(iter(gnu_mt.values() or musl_mt.values()))["threads"]
+    lines = ["### Concurrent scaling\n"]
+    lines.append(
+        f"Every benchmark on {threads:.0f} threads at once, each with its own "
+        "state (`run.sh --concurrent`, benchmark `-j`). Throughput is the "
+        "aggregate over all threads; slowdown is per-thread ns/op over the "
+        "single-thread ns/op of the same run. Kernels flagged `BENCH_F_NOT_MT` "
+        "are left out.")
+    lines.append("")
+    lines.append("| Benchmark | glibc ops/s | glibc slowdown | musl ops/s | musl slowdown "
+                 "| musl vs glibc (ops/s) |")
+    lines.append("|---|---|---|---|---|---|")
+    for name in sorted(set(gnu_mt) | set(musl_mt)):
+        row = [name]
+        for mt in (gnu_mt, musl_mt):
+            r = mt.get(name)
+            row.append(f"{r['ops_per_sec']:.0f}" if r else "-")
+            row.append(f"{r['slowdown']:.2f}x" if r else "-")
+        g, m = gnu_mt.get(name), musl_mt.get(name)
+        if g and m and g["ops_per_sec"] > 0:
+            row.append(f"{(m['ops_per_sec'] / g['ops_per_sec'] - 1.0) * 100.0:+.2f}%")
+        else:
+            row.append("-")
+        lines.append("| " + " | ".join(row) + " |")
+    return lines
+
+
+def render_profiles(directory):
+    """Links to the flame graphs and folded stacks of run.sh --profile."""
+    graphs = {}
+    for svg in sorted(directory.glob("*.svg")):
+        libc, _, name = svg.stem.partition(".")
+        graphs.setdefault(name, {})[libc] = svg
+    if not graphs:
+        return []
+    lines = ["", "### Profiles\n"]
+    lines.append(
+        "`perf record` flame graphs of the headline cells, rebuilt unstripped with "
+        "frame pointers (`run.sh --profile`, patterns from `PROFILE_BENCHMARKS`). "
+        "The `.folded` files hold the collapsed stacks.")
+    lines.append("")
+    lines.append("| Benchmark | glibc | musl |")
+    lines.append("|---|---|---|")
+    for name, by_libc in sorted(graphs.items()):
+        row = [name]
+        for libc in ("gnu", "musl"):
+            svg = by_libc.get(libc)
+            row.append(f"[svg]({svg.as_posix()}) · [folded]({svg.with_suffix('.folded').as_posix()})"
+                       if svg else "-")
+        lines.append("| " + " | ".join(row) + " |")
+    return lines
+
+
+def render_metrics(gnu, musl):
+    """Extra per-benchmark values kernels report with bench_metric()."""
+    rows = []
+    for name in sorted(set(gnu) | set(musl)):
+        g = gnu.get(name, {}).get("metrics", {})
+        m = musl.get(name, {}).get("metrics", {})
+        for key in sorted(set(g) | set(m)):
+            values = [f"{r[key]:.2f}" if key in r else "-" for r in (g, m)]
+            rows.append(f"| {name} | {key} | {values[0]} | {values[1]} |")
+    if not rows:
+        return []
+    lines = ["", "### Reported metrics\n"]
+    lines.append(
+        "Values kernels attach to their rows, e.g. `bytes_per_key`: resident "
+        "memory a container holds per key. `allocs_per_op` counts malloc, calloc, "
+        "realloc, posix_memalign and aligned_alloc calls per operation (`run.sh --allocs`), through "
+        "`--wrap` in statically linked cells and the preloaded `plugins/alloc_count.c` in dynamic "
+        "ones.")
+    lines.append("")
+    lines.append("| Benchmark | Metric | glibc | musl |")
+    lines.append("|---|---|---|---|")
+    lines.extend(rows)
+    return lines
+
+
+def load_pass(suffix):
+    """Headline (glibc, musl) results of an extra run.sh pass, e.g. "cold"."""
+    return (load(RESULTS_DIR / f"benchmark-gnu.{suffix}.csv"),
+            load(RESULTS_DIR / f"benchmark-musl.{suffix}.csv"))
+
+
+def rel_display(g_ns, m_ns):
+    """musl vs glibc as shown in the headline table."""
+    if g_ns == 0:
+        return "-"
+    rel_pct = (m_ns / g_ns - 1.0) * 100.0
+    if rel_pct > 0:
+        return f"-{rel_pct:.2f}% slower"
+    return f"+{-rel_pct:.2f}% faster"
+
+
+def render_variant(title, note, base_name, variant_name, gnu, musl, gnu_v, musl_v):
+    """
+    Default-pass ns/op next to an extra pass (cold cache, input pools, ...)
+    for every benchmark the extra pass measured.
+    """
+    lines = [f"### {title}\n", note, ""]
+    lines.append(f"| Benchmark | glibc {base_name} | glibc {variant_name} "
+                 f"| musl {base_name} | musl {variant_name} "
+                 f"| musl vs glibc ({variant_name}) |")
+    lines.append("|---|---|---|---|---|---|")
+    for name in sorted(set(gnu_v) | set(musl_v)):
+        row = [name]
+        for base, variant in ((gnu, gnu_v), (musl, musl_v)):
+            b, v = base.get(name), variant.get(name)
+            row.append(f"{b['ns_per_op']:.2f}" if b else "-")
+            row.append(f"{v['ns_per_op']:.2f}" if v else "-")
+        g, m = gnu_v.get(name), musl_v.get(name)
+        row.append(rel_display(g["ns_per_op"], m["ns_per_op"]) if g and m else "-")
+        lines.append("| " + " | ".join(row) + " |")
+    return lines
+
+
+def load_profiles(directory):
+    """
+    Returns list of (name, entries) for every *.profile file in directory.
+    Each non-comment line is: benchmark calls_per_request [weight]
+      calls_per_request: how often the service calls the function per request
+                         (e.g. ltrace -c / uprobe counts divided by requests)
+      weight:            cost of one real call relative to one benchmark op
+                         (default 1.0; e.g. 0.1 for 100-byte strlen vs. 1 KiB)
+    """
+    profiles = []
+    if not directory.is_dir():
+        return profiles
+    for path in sorted(directory.glob("*.profile")):
+        entries = []
+        with path.open("r", encoding="utf-8") as f:
+            for lineno, line in enumerate(f, 1):
+                line = line.split("#", 1)[0].strip()
+                if not line:
+                    continue
+                parts = line.split()
+                if len(parts) not in (2, 3):
+                    raise ValueError(f"{path}:{lineno}: expected 'benchmark calls [weight]'")
+                weight = float(parts[2]) if len(parts) == 3 else 1.0
+                entries.append((parts[0], float(parts[1]), weight))
+        profiles.append((path.stem, entries))
+    return profiles
+
+
+def project_profile(entries, results):
+    """
+    Projected libc time per request: sum(calls * weight * ns_per_op).
+    The bound propagates each benchmark's standard error of the mean,
+    assuming independent benchmarks. Returns (ns, ci95_ns, missing).
+    """
+    total = 0.0
+    var = 0.0
+    missing = []
+    for name, calls, weight in entries:
+        r = results.get(name)
+        if not r:
+            missing.append(name)
+            continue
+        scale = calls * weight
+        total += scale * r["ns_per_op"]
+        se = r["ns_per_op_sd"] / math.sqrt(r["samples"])
+        var += (scale * se) ** 2
+    return total, Z_95 * math.sqrt(var), missing
+
+
+def load_matrix(directory):
+    """
+    Returns list of (cell, results) for every built cell listed in
+    directory/cells.csv, where cell is a dict of the cells.csv columns
+    (label,compiler,libc,opt,march,link,alloc,...).
+    """
+    index = directory / "cells.csv"
+    if not index.exists():
+        return []
+    with index.open("r", encoding="utf-8") as f:
+        rows = [ln.strip().split(",") for ln in f if ln.strip()]
+    if not rows:
+        return []
+    header = rows[0]
+    cells = []
+    for row in rows[1:]:
+        cell = dict(zip(header, row))
+        cell.setdefault("alloc", "system")
+        results = load(directory / f"{cell['label']}.csv")
+        if results:
+            cells.append((cell, results))
+    return cells
+
+
+def load_footprints(directory):
+    """[(cell, {metric: value})] for cells with a <label>.footprint.csv (run.sh --footprint)."""
+    index = directory / "cells.csv"
+    if not index.exists():
+        return []
+    with index.open("r", encoding="utf-8") as f:
+        rows = [ln.strip().split(",") for ln in f if ln.strip()]
+    out = []
+    for row in rows[1:]:
+        cell = dict(zip(rows[0], row))
+        path = directory / f"{cell['label']}.footprint.csv"
+        if not path.exists():
+            continue
+        with path.open("r", encoding="utf-8") as f:
+            metrics = dict(ln.strip().split(",", 1) for ln in f.readlines()[1:] if "," in ln)
+        out.append((cell, metrics))
+    return out
+
+
+def render_footprint(footprints):
+    """Binary size, linked libc code, build time and startup cost per cell."""
+    def kib(metrics, key):
+        value = metrics.get(key, "-")
+        return f"{int(value) / 1024:.1f}" if value.isdigit() else "-"
+
+    lines = ["", "### Footprint\n"]
+    lines.append(
+        "Per build cell (`run.sh --footprint`, builds run one at a time): file "
+        "sizes in KiB with and without `-s`, loaded sections of the stripped "
+        "binary, libc functions linked in (static: defined in the binary, with "
+        "their code size; dynamic: imported), wall-clock build time, and an "
+        "empty `main` built with the same flags: its size, peak RSS and minor "
+        "page faults at startup (median of 20 runs). Function lists and "
+        "per-section sizes are in `results/matrix/<label>.libc_functions.txt` "
+        "and `<label>.footprint.csv`.")
+    lines.append("")
+    lines.append("| Cell | stripped | unstripped | text | rodata | data | bss | libc functions "
+                 "| build s | empty main | startup RSS KiB | startup faults |")
+    lines.append("|---|---|---|---|---|---|---|---|---|---|---|---|")
+    for cell, m in footprints:
+        funcs = m.get("libc_functions", "-")
+        if m.get("libc_function_bytes", "-").isdigit():
+            funcs += f" ({kib(m, 'libc_function_bytes')} KiB)"
+        build = m.get("build_ms", "-")
+        build = f"{int(build) / 1000:.1f}" if build.isdigit() else "-"
+        lines.append(
+            f"| {cell['label']} | {kib(m, 'stripped_bytes')} | {kib(m, 'unstripped_bytes')} "
+            f"| {kib(m, 'text_bytes')} | {kib(m, 'rodata_bytes')} | {kib(m, 'data_bytes')} "
+            f"| {kib(m, 'bss_bytes')} | {funcs} | {build} | {kib(m, 'empty_main_bytes')} "
+            f"| {m.get('startup_rss_kib', '-')} | {m.get('startup_minflt', '-')} |")
+    return lines
+
+
+def geomean_ratio(results, baseline):
+    """Geometric mean of results/baseline ns/op over shared benchmarks."""
+    logs = [
+        math.log(results[name]["ns_per_op"] / baseline[name]["ns_per_op"])
+        for name in results
+        if name in baseline
+        and results[name]["ns_per_op"] > 0
+        and baseline[name]["ns_per_op"] > 0
+    ]
+    if not logs:
+        return None
+    return math.exp(sum(logs) / len(logs))
+
+
+def render_matrix(cells, config_keys=("compiler", "opt", "march", "link")):
+    """
+    Pivot of the build matrix: one row per build configuration, one column
+    per libc, each entry the geometric mean ns/op relative to the first glibc
+    cell. A per-benchmark ns/op table for every cell follows in a <details>.
+    """
+    lines = []
+    # Allocator cells only run the allocator benchmarks; see render_allocators
+    cells = [(c, r) for c, r in cells if c["alloc"] == "system"]
+    baseline_cell, baseline = next(
+        ((c, r) for c, r in cells if c["libc"] == "gnu"), cells[0])
+    libcs = []
+    configs = {}
+    for cell, results in cells:
+        if cell["libc"] not in libcs:
+            libcs.append(cell["libc"])
+        key = tuple(cell.get(k, "") for k in config_keys)
+        configs.setdefault(key, {})[cell["libc"]] = results
+
+    lines.append("### Build matrix\n")
+    lines.append(
+        f"Geometric mean ns/op relative to `{baseline_cell['label']}` "
+        "(lower is better).")
+    lines.append("")
+    lines.append("| " + " | ".join(config_keys) + " | "
+                 + " | ".join(libcs) + " |")
+    lines.append("|" + "---|" * (len(config_keys) + len(libcs)))
+    for key, per_libc in configs.items():
+        row = list(key)
+        for libc in libcs:
+            r = per_libc.get(libc)
+            ratio = geomean_ratio(r, baseline) if r else None
+            row.append(f"{ratio:.3f}" if ratio is not None else "-")
+        lines.append("| " + " | ".join(row) + " |")
+
+    names = sorted(set().union(*(r.keys() for _, r in cells)))
+    lines.append("")
+    lines.append("<details><summary>ns/op per matrix cell</summary>\n")
+    lines.append("| Benchmark | " + " | ".join(c["label"] for c, _ in cells) + " |")
+    lines.append("|---|" + "---|" * len(cells))
+    for name in names:
+        row = [name]
+        for _, results in cells:
+            r = results.get(name)
+            row.append(f"{r['ns_per_op']:.2f}" if r else "-")
+        lines.append("| " + " | ".join(row) + " |")
+    lines.append("\n</details>")
+    return lines
+
+
+def render_linkage(cells):
+    """
+    Static vs. dynamic comparison for every build configuration that has
+    both link modes for at least one libc. The dynamic columns show the
+    cost of PLT/GOT indirection and run-time IFUNC resolution relative to
+    the static build of the same libc (positive = dynamic is slower).
+    """
+    groups = {}
+    for cell, results in cells:
+        if cell.get("link") not in ("static", "dynamic") or cell["alloc"] != "system":
+            continue
+        key = (cell["compiler"], cell["opt"], cell["march"])
+        groups.setdefault(key, {})[(cell["libc"], cell["link"])] = results
+
+    lines = []
+    for (compiler, opt, march), variants in groups.items():
+        libcs = [libc for libc in ("gnu", "musl")
+                 if (libc, "static") in variants and (libc, "dynamic") in variants]
+        if not libcs:
+            continue
+        names = sorted(set().union(*(variants[(l, m)].keys()
+                                     for l in libcs for m in ("static", "dynamic"))))
+        lines.append("")
+        lines.append(f"### Static vs dynamic linking ({compiler} {opt} -march={march})\n")
+        lines.append(
+            "ns/op per linkage; `dyn cost` is the dynamic build relative to the "
+            "static build of the same libc. Compare the `call_*_strlen` rows "
+            "for the per-call PLT/IFUNC overhead.")
+        lines.append("")
+        header = ["Benchmark"]
+        for libc in libcs:
+            label = "glibc" if libc == "gnu" else libc
+            header += [f"{label} static", f"{label} dynamic", f"{label} dyn cost"]
+        lines.append("| " + " | ".join(header) + " |")
+        lines.append("|" + "---|" * len(header))
+        for name in names:
+            row = [name]
+            for libc in libcs:
+                st = variants[(libc, "static")].get(name)
+                dy = variants[(libc, "dynamic")].get(name)
+                row.append(f"{st['ns_per_op']:.2f}" if st else "-")
+                row.append(f"{dy['ns_per_op']:.2f}" if dy else "-")
+                if st and dy and st["ns_per_op"] > 0:
+                    row.append(f"{(dy['ns_per_op'] / st['ns_per_op'] - 1.0) * 100.0:+.2f}%")
+                else:
+                    row.append("-")
+            lines.append("| " + " | ".join(row) + " |")
+    return lines
+
+
+def render_allocators(cells):
+    """
+    Allocator benchmarks for every libc/allocator combination of a build
+    configuration, relative to glibc with its own malloc in that same
+    configuration.
+    """
+    groups = {}
+    for cell, results in cells:
+        key = (cell["compiler"], cell["opt"], cell["march"], cell["link"])
+        groups.setdefault(key, []).append((cell, results))
+
+    lines = []
+    for (compiler, opt, march, link), members in groups.items():
+        if all(c["alloc"] == "system" for c, _ in members):
+            continue
+        baseline = next((r for c, r in members
+                         if c["libc"] == "gnu" and c["alloc"] == "system"), None)
+        names = sorted(set().union(*(r.keys() for c, r in members
+                                     if c["alloc"] != "system")))
+        columns = []
+        for cell, results in members:
+            label = "glibc" if cell["libc"] == "gnu" else cell["libc"]
+            if cell["alloc"] != "system":
+                label += f" + {cell['alloc']}"
+            columns.append((label, results))
+        lines.append("")
+        lines.append(f"### Allocators ({compiler} {opt} -march={march}, {link} link)\n")
+        lines.append("ns/op; percentages are relative to glibc's own malloc "
+                     "(positive = slower).")
+        lines.append("")
+        lines.append("| Benchmark | " + " | ".join(l for l, _ in columns) + " |")
+        lines.append("|---|" + "---|" * len(columns))
+        for name in names:
+            row = [name]
+            base = baseline.get(name) if baseline else None
+            for _, results in columns:
+                r = results.get(name)
+                if not r:
+                    row.append("-")
+                elif base and base["ns_per_op"] > 0 and r is not base:
+                    rel = (r["ns_per_op"] / base["ns_per_op"] - 1.0) * 100.0
+                    row.append(f"{r['ns_per_op']:.2f} ({rel:+.1f}%)")
+                else:
+                    row.append(f"{r['ns_per_op']:.2f}")
+            lines.append("| " + " | ".join(row) + " |")
+    return lines
+
+
 def main():
     gnu = load(GNU_FILE)
     musl = load(MUSL_FILE)
 
-    all_benchmarks = sorted(set(gnu) | set(musl))
+    # Reference loops do not depend on the libc; they only feed the roofline
+    all_benchmarks = sorted(n for n in set(gnu) | set(musl) if not n.startswith("ref_"))
 
     def _get_compiler_version():
         zig_ver = subprocess.check_output(
@@ -209,6 +830,7 @@ def main():
     glibc_faster = 0
     musl_faster = 0
     ties = 0
+    suspects = []
 
     total_time_glibc = 0
     total_time_musl = 0
@@ -224,6 +846,13 @@ def main():
         total_time_glibc += g.get("time_ns", 0)
         total_time_musl += m.get("time_ns", 0)
 
+        # Implausibly fast rows measured an optimized-away loop: no winner
+        if g["suspect"] or m["suspect"]:
+            suspects.append(name)
+            lines.append(
+                f"| {name} ⚠ | {g_ns:.2f} | {m_ns:.2f} | - | suspect |")
+            continue
+
         # Define tie threshold (percent difference)
         TIE_THRESHOLD_PCT = 0.5  # musl within ±0.5% of glibc counts as tie
 
@@ -260,6 +889,19 @@ def main():
     lines.append(f"- glibc faster (ns/op): {glibc_faster}")
     lines.append(f"- musl faster (ns/op): {musl_faster}")
     lines.append(f"- Ties (ns/op): {ties}")
+    if suspects:
+        lines.append(
+            f"- Suspect (⚠, excluded): {', '.join(suspects)} — ns/op implies more "
+            "bytes per cycle than the hardware can move, so the compiler likely "
+            "removed the work")
+    for label, results in (("glibc", gnu), ("musl", musl)):
+        rses = sorted((r["rse_pct"], n) for n, r in results.items()
+                      if r["rse_pct"] is not None and n in all_benchmarks)
+        if rses:
+            lines.append(
+                f"- {label} precision: median relative standard error "
+                f"{statistics.median(v for v, _ in rses):.2f}%, worst {rses[-1][0]:.2f}% "
+                f"({rses[-1][1]})")
     if glibc_faster > musl_faster:
         lines.append("- Overall (by count): glibc wins more benchmarks.")
     elif musl_faster > glibc_faster:
@@ -267,6 +909,119 @@ def main():
     else:
         lines.append("- Overall (by count): tie.")
 
+    footprints = load_footprints(MATRIX_DIR)
+    if footprints:
+        lines.extend(render_footprint(footprints))
+    lines.extend(render_applications(gnu, musl))
+    lines.extend(render_roofline(gnu, musl))
+    lines.extend(render_sorting(gnu, musl))
+
+    profiles = load_profiles(PROFILES_DIR)
+    if profiles:
+        lines.append("")
+        lines.append("### Workload profiles\n")
+        lines.append(
+            "Projected libc time per request for each profile in `profiles/` "
+            "(mean ± 95% confidence bound).")
+        lines.append("")
+        lines.append(
+            "| Profile | glibc ns/request | musl ns/request | musl vs glibc | Winner |")
+        lines.append(
+            "|---------|------------------|-----------------|---------------|--------|")
+        notes = []
+        for pname, entries in profiles:
+            g_ns, g_ci, g_missing = project_profile(entries, gnu)
+            m_ns, m_ci, m_missing = project_profile(entries, musl)
+            missing = sorted(set(g_missing) | set(m_missing))
+            if missing:
+                notes.append(
+                    f"- `{pname}`: no results for {', '.join(missing)} (excluded)")
+            if g_ns == 0:
+                continue
+            rel_pct = (m_ns / g_ns - 1.0) * 100.0
+            rel_display = (f"-{rel_pct:.2f}% slower" if rel_pct > 0
+                           else f"+{-rel_pct:.2f}% faster")
+            # Only call a winner when the confidence intervals do not overlap
+            if g_ns + g_ci < m_ns - m_ci:
+                winner = "glibc"
+            elif m_ns + m_ci < g_ns - g_ci:
+                winner = "musl"
+            else:
+                winner = "inconclusive"
+            lines.append(
+                f"| {pname} | {g_ns:.2f} ± {g_ci:.2f} | {m_ns:.2f} ± {m_ci:.2f} "
+                f"| {rel_display} | {winner} |")
+        if notes:
+            lines.append("")
+            lines.extend(notes)
+
+    gnu_cold, musl_cold = load_pass("cold")
+    if gnu_cold or musl_cold:
+        lines.append("")
+        lines.extend(render_variant(
+            "Hot vs cold cache",
+            "Cold rows rotate each kernel over copies of its buffers spanning "
+            "several times the last-level cache (`run.sh --cold`, benchmark `-c`).",
+            "hot", "cold", gnu, musl, gnu_cold, musl_cold))
+
+    gnu_pool, musl_pool = load_pass("pool")
+    if gnu_pool or musl_pool:
+        lines.append("")
+        lines.extend(render_variant(
+            "Fixed vs randomized inputs",
+            "Pool rows draw every call from a seeded pool of varied lengths, "
+            "mismatch positions and contents (`run.sh --pool`, benchmark `-p`).",
+            "fixed", "pool", gnu, musl, gnu_pool, musl_pool))
+
+    gnu_huge, musl_huge = load_pass("huge")
+    if gnu_huge or musl_huge:
+        lines.append("")
+        lines.extend(render_variant(
+            "Regular vs huge pages",
+            "Huge rows back large buffers and rings with transparent huge pages "
+            "or hugetlbfs pages, optionally bound to one NUMA node (`run.sh "
+            "--hugepages`, benchmark `-H`/`-N`). `thp_pct` under \"Reported "
+            "metrics\" shows how much of each buffer was actually huge.",
+            "4k", "huge", gnu, musl, gnu_huge, musl_huge))
+
+    gnu_stream, musl_stream = load_pass("stream")
+    if gnu_stream or musl_stream:
+        lines.append("")
+        lines.extend(render_streaming(gnu_stream, musl_stream))
+
+    gnu_lat = load_rows(RESULTS_DIR / "benchmark-gnu.latency.csv")
+    musl_lat = load_rows(RESULTS_DIR / "benchmark-musl.latency.csv")
+    if gnu_lat or musl_lat:
+        lines.append("")
+        lines.extend(render_latency(gnu_lat, musl_lat))
+
+    gnu_mt = load_rows(RESULTS_DIR / "benchmark-gnu.mt.csv")
+    musl_mt = load_rows(RESULTS_DIR / "benchmark-musl.mt.csv")
+    if gnu_mt or musl_mt:
+        lines.append("")
+        lines.extend(render_concurrent(gnu_mt, musl_mt))
+
+    # Allocation counts come from their own pass (run.sh --allocs)
+    gnu_allocs, musl_allocs = load_pass("allocs")
+    for base, extra in ((gnu, gnu_allocs), (musl, musl_allocs)):
+        for name, r in extra.items():
+            if name in base:
+                base[name]["metrics"].update(r["metrics"])
+    for base, extra in ((gnu, gnu_huge), (musl, musl_huge)):
+        for name, r in extra.items():
+            if name in base:
+                for key, value in r["metrics"].items():
+                    base[name]["metrics"][f"{key} (huge)"] = value
+    lines.extend(render_profiles(PROFILE_DIR))
+    lines.extend(render_metrics(gnu, musl))
+
+    cells = load_matrix(MATRIX_DIR)
+    if len(cells) > 2:
+        lines.append("")
+        lines.extend(render_matrix(cells))
+    lines.extend(render_linkage(cells))
+    lines.extend(render_allocators(cells))
+
     OUT_MD.write_text("\n".join(lines) + "\n", encoding="utf-8")
     print(f"Wrote {OUT_MD}")
 
@@ -0,0 +1,278 @@
+#define _GNU_SOURCE
+#include <malloc.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libcbench.h"
+
+/*
+ * Allocator paths past plain malloc/free:
+ *
+ * - calloc_<size> against malloc_memset_<size>: allocate, write one byte per
+ *   page and free. Above the mmap threshold calloc can hand out fresh zero
+ *   pages without clearing them; below it both have to clear.
+ * - posix_memalign_<align> and aligned_alloc_<align>, 64 B to 2 MiB, in
+ *   batches of 16 blocks of max(align, 64 KiB), freed in reverse.
+ * - malloc_usable_size over 256 live blocks of mixed sizes.
+ * - malloc_large_<size>, 64 KiB to 64 MiB: malloc/free pairs on either side
+ *   of the mmap threshold (128 KiB by default in both libcs; glibc raises it
+ *   to the size of freed mmapped blocks up to 32 MiB). The first-touch cost
+ *   of the same sizes is the malloc_touch_* sweep in largemem.c.
+ */
+
+#define PAGE 4096
+
+static size_t run_zeroed(size_t len, int use_calloc, size_t iters)
+{
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        unsigned char *p;
+        if (use_calloc)
+        {
+            p = calloc(1, len);
+            if unlikely (!p)
+                bench_out_of_memory();
+        }
+        else
+        {
+            p = xmalloc(len);
+            memset(p, 0, len);
+        }
+        for (size_t k = 0; k < len; k += PAGE)
+            p[k] |= (unsigned char)k;
+        BENCH_CLOBBER_MEMORY();
+        free(p);
+        ops++;
+    }
+    return ops;
+}
+
+#define ZEROED(tag, len)                                                                               \
+    static size_t run_calloc_##tag(void *state, size_t iters)                                        \
+    {                                                                                                  \
+        (void)state;                                                                                   \
+        return run_zeroed(len, 1, iters);                                                              \
+    }                                                                                                  \
+    static size_t run_malloc_memset_##tag(void *state, size_t iters)                                 \
+    {                                                                                                  \
+        (void)state;                                                                                   \
+        return run_zeroed(len, 0, iters);                                                              \
+    }
+ZEROED(4k, (size_t)4 << 10)
+ZEROED(128k, (size_t)128 << 10)
+ZEROED(1m, (size_t)1 << 20)
+ZEROED(16m, (size_t)16 << 20)
+
+#define ALIGN_BATCH 16
+#define ALIGN_MIN_SIZE ((size_t)64 << 10)
+
+typedef struct
+{
+    size_t align;
+    size_t size;
+    void *ptrs[ALIGN_BATCH];
+} align_state;
+
+static void init_align(void **state, size_t align)
+{
+    align_state *st = xmalloc(sizeof(*st));
+    st->align = align;
+    /* aligned_alloc wants a multiple of the alignment */
+    st->size = align > ALIGN_MIN_SIZE ? align : ALIGN_MIN_SIZE;
+    *state = st;
+}
+
+static void *alloc_aligned(const align_state *st, int posix)
+{
+    void *p = NULL;
+    if unlikely (posix ? posix_memalign(&p, st->align, st->size) != 0 : !(p = aligned_alloc(st->align, st->size)))
+        bench_out_of_memory();
+    return p;
+}
+
+/* One op per allocation and per free, as in malloc_free_* */
+static size_t run_align(align_state *st, int posix, size_t iters)
+{
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        for (int k = 0; k < ALIGN_BATCH; k++)
+        {
+            st->ptrs[k] = alloc_aligned(st, posix);
+            BENCH_DO_NOT_OPTIMIZE(st->ptrs[k]);
+            ops++;
+        }
+        for (int k = ALIGN_BATCH - 1; k >= 0; k--)
+        {
+            free(st->ptrs[k]);
+            ops++;
+        }
+    }
+    return ops;
+}
+
+static size_t lat_align(align_state *st, int posix, size_t iters, bench_hist *h)
+{
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        for (int k = 0; k < ALIGN_BATCH; k++)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            st->ptrs[k] = alloc_aligned(st, posix);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            BENCH_DO_NOT_OPTIMIZE(st->ptrs[k]);
+            ops++;
+        }
+        for (int k = ALIGN_BATCH - 1; k >= 0; k--)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            free(st->ptrs[k]);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            ops++;
+        }
+    }
+    return ops;
+}
+
+static size_t run_posix_memalign(void *state, size_t iters)
+{
+    return run_align((align_state *)state, 1, iters);
+}
+
+static size_t run_aligned_alloc(void *state, size_t iters)
+{
+    return run_align((align_state *)state, 0, iters);
+}
+
+static size_t lat_posix_memalign(void *state, size_t iters, bench_hist *h)
+{
+    return lat_align((align_state *)state, 1, iters, h);
+}
+
+static size_t lat_aligned_alloc(void *state, size_t iters, bench_hist *h)
+{
+    return lat_align((align_state *)state, 0, iters, h);
+}
+
+#define ALIGN_INIT(tag, align) \
+    static void init_align_##tag(void **state) { init_align(state, align); }
+ALIGN_INIT(64, 64)
+ALIGN_INIT(4k, (size_t)4 << 10)
+ALIGN_INIT(64k, (size_t)64 << 10)
+ALIGN_INIT(2m, (size_t)2 << 20)
+
+#define USABLE_BLOCKS 256
+
+typedef struct
+{
+    void *ptrs[USABLE_BLOCKS];
+} usable_state;
+
+/* Sizes from 1 B to 8 KiB, so every size class range is hit */
+static void init_usable(void **state)
+{
+    usable_state *st = xmalloc(sizeof(*st));
+    for (int i = 0; i < USABLE_BLOCKS; i++)
+        st->ptrs[i] = xmalloc(bench_rand_range(1, 8192));
+    *state = st;
+}
+
+static void cleanup_usable(void *state)
+{
+    usable_state *st = (usable_state *)state;
+    for (int i = 0; i < USABLE_BLOCKS; i++)
+        free(st->ptrs[i]);
+    free(st);
+}
+
+static size_t run_usable(void *state, size_t iters)
+{
+    usable_state *st = (usable_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t total = 0;
+        for (int k = 0; k < USABLE_BLOCKS; k++)
+            total += malloc_usable_size(st->ptrs[k]);
+        BENCH_DO_NOT_OPTIMIZE(total);
+        ops += USABLE_BLOCKS;
+    }
+    return ops;
+}
+
+static size_t lat_usable(void *state, size_t iters, bench_hist *h)
+{
+    usable_state *st = (usable_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        for (int k = 0; k < USABLE_BLOCKS; k++)
+        {
+            uint64_t t0 = bench_tsc_begin();
+            size_t n = malloc_usable_size(st->ptrs[k]);
+            bench_hist_record(h, bench_tsc_end() - t0);
+            BENCH_DO_NOT_OPTIMIZE(n);
+            ops++;
+        }
+    }
+    return ops;
+}
+
+/* Untouched blocks: only the allocator's own bookkeeping and mmap/munmap */
+static size_t run_large(size_t len, size_t iters)
+{
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        void *p = xmalloc(len);
+        BENCH_DO_NOT_OPTIMIZE(p);
+        free(p);
+        ops++;
+    }
+    return ops;
+}
+
+#define LARGE(tag, len)                                            \
+    static size_t run_large_##tag(void *state, size_t iters)     \
+    {                                                              \
+        (void)state;                                               \
+        return run_large(len, iters);                              \
+    }
+LARGE(64k, (size_t)64 << 10)
+LARGE(128k, (size_t)128 << 10)
+LARGE(256k, (size_t)256 << 10)
+LARGE(1m, (size_t)1 << 20)
+LARGE(64m, (size_t)64 << 20)
+
+static void cleanup_free(void *state)
+{
+    free(state);
+}
+
+#define ALIGN_ENTRIES(tag)                                                                                       \
+    {"posix_memalign_" #tag, init_align_##tag, run_posix_memalign, cleanup_free, 0, lat_posix_memalign},       \
+        {"aligned_alloc_" #tag, init_align_##tag, run_aligned_alloc, cleanup_free, 0, lat_aligned_alloc}
+
+static const Benchmark alloc_benchmarks[] = {
+    {"calloc_4k", NULL, run_calloc_4k, NULL},
+    {"malloc_memset_4k", NULL, run_malloc_memset_4k, NULL},
+    {"calloc_128k", NULL, run_calloc_128k, NULL},
+    {"malloc_memset_128k", NULL, run_malloc_memset_128k, NULL},
+    {"calloc_1m", NULL, run_calloc_1m, NULL},
+    {"malloc_memset_1m", NULL, run_malloc_memset_1m, NULL},
+    {"calloc_16m", NULL, run_calloc_16m, NULL},
+    {"malloc_memset_16m", NULL, run_malloc_memset_16m, NULL},
+    ALIGN_ENTRIES(64),
+    ALIGN_ENTRIES(4k),
+    ALIGN_ENTRIES(64k),
+    ALIGN_ENTRIES(2m),
+    {"malloc_usable_size", init_usable, run_usable, cleanup_usable, 0, lat_usable},
+    {"malloc_large_64k", NULL, run_large_64k, NULL},
+    {"malloc_large_128k", NULL, run_large_128k, NULL},
+    {"malloc_large_256k", NULL, run_large_256k, NULL},
+    {"malloc_large_1m", NULL, run_large_1m, NULL},
+    {"malloc_large_64m", NULL, run_large_64m, NULL},
+};
+BENCH_REGISTER_TABLE(alloc_benchmarks)
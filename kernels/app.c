@@ -0,0 +1,595 @@
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+#include "../libcbench.h"
+
+/*
+ * Composite workloads: what a small service does per record, built only from
+ * libc calls, so gaps between the primitives compound as they would in
+ * production. One operation is one record (request, line, object or log
+ * entry), so ops/s reads as records/s.
+ *
+ *   app_http_parse      request line and headers (strchr, strncmp, strtol)
+ *   app_csv_load        CSV file to binary records (getline, strtol, strtod)
+ *   app_json_serialize  records to JSON text (snprintf, memcpy)
+ *   app_kv_store        get/put/delete on malloc'd hash nodes, with a qsort
+ *                       compaction pass every KV_COMPACT requests
+ *   app_log_format      access-log lines (gmtime_r, strftime, fprintf)
+ */
+
+#define APP_POOL 256 /* power of two */
+
+static const char *const METHODS[] = {"GET", "POST", "PUT", "DELETE", "HEAD"};
+
+/* Random lower-case word of lo..hi letters into buf, NUL-terminated */
+static size_t app_word(char *buf, size_t lo, size_t hi)
+{
+    size_t len = bench_rand_range(lo, hi);
+    for (size_t i = 0; i < len; i++)
+        buf[i] = (char)('a' + bench_rand() % 26);
+    buf[len] = '\0';
+    return len;
+}
+
+/* 1. HTTP request parsing */
+#define HTTP_MAX 1024
+
+typedef struct
+{
+    char text[APP_POOL][HTTP_MAX];
+} http_state;
+
+typedef struct
+{
+    const char *method;
+    size_t method_len;
+    const char *path;
+    size_t path_len;
+    int minor;
+    long content_length;
+    int keep_alive;
+    size_t headers;
+} http_request;
+
+static void init_http(void **state)
+{
+    http_state *st = xmalloc(sizeof(*st));
+    for (size_t i = 0; i < APP_POOL; i++)
+    {
+        const char *method = METHODS[bench_rand() % 5];
+        int body = method[0] == 'P';
+        char word[24];
+        app_word(word, 3, 12);
+        char *p = st->text[i];
+        size_t room = HTTP_MAX;
+        int n = snprintf(p, room,
+                         "%s /api/v1/%s/%llu?page=%u HTTP/1.1\r\n"
+                         "Host: service-%u.internal.example.com\r\n"
+                         "User-Agent: Mozilla/5.0 (X11; Linux x86_64) client/%u.%u\r\n"
+                         "Accept: application/json, text/plain, */*\r\n"
+                         "Accept-Encoding: gzip, deflate, br\r\n"
+                         "Connection: %s\r\n"
+                         "X-Request-Id: %016llx\r\n",
+                         method, word, (unsigned long long)(bench_rand() % 1000000),
+                         (unsigned)(bench_rand() % 50), (unsigned)(bench_rand() % 16),
+                         (unsigned)(bench_rand() % 100), (unsigned)(bench_rand() % 10),
+                         bench_rand() % 4 ? "keep-alive" : "close",
+                         (unsigned long long)bench_rand());
+        p += n;
+        room -= (size_t)n;
+        if (bench_rand() % 2)
+        {
+            app_word(word, 16, 23);
+            n = snprintf(p, room, "Cookie: session=%s; theme=dark\r\n", word);
+            p += n;
+            room -= (size_t)n;
+        }
+        if (body)
+        {
+            n = snprintf(p, room, "Content-Type: application/json\r\nContent-Length: %u\r\n",
+                         (unsigned)bench_rand_range(2, 65536));
+            p += n;
+            room -= (size_t)n;
+        }
+        snprintf(p, room, "\r\n");
+    }
+    *state = st;
+}
+
+/* Returns 0 on success; field pointers refer into text */
+static int http_parse(const char *text, http_request *r)
+{
+    memset(r, 0, sizeof(*r));
+    r->content_length = -1;
+    const char *sp = strchr(text, ' ');
+    if (!sp)
+        return -1;
+    r->method = text;
+    r->method_len = (size_t)(sp - text);
+    r->path = sp + 1;
+    sp = strchr(r->path, ' ');
+    if (!sp || strncmp(sp + 1, "HTTP/1.", 7) != 0)
+        return -1;
+    r->path_len = (size_t)(sp - r->path);
+    r->minor = sp[8] - '0';
+    r->keep_alive = r->minor == 1;
+    const char *line = strchr(sp, '\n');
+    while (line && line[1] != '\r' && line[1] != '\0')
+    {
+        line++;
+        const char *colon = strchr(line, ':');
+        if (!colon)
+            return -1;
+        const char *value = colon + 1;
+        while (*value == ' ')
+            value++;
+        size_t name_len = (size_t)(colon - line);
+        if (name_len == 14 && strncasecmp(line, "Content-Length", 14) == 0)
+            r->content_length = strtol(value, NULL, 10);
+        else if (name_len == 10 && strncasecmp(line, "Connection", 10) == 0)
+            r->keep_alive = strncasecmp(value, "keep-alive", 10) == 0;
+        r->headers++;
+        line = strchr(value, '\n');
+    }
+    return line ? 0 : -1;
+}
+
+static size_t run_http_parse(void *state, size_t iters)
+{
+    http_state *st = (http_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        http_request r;
+        int rc = http_parse(st->text[i & (APP_POOL - 1)], &r);
+        BENCH_DO_NOT_OPTIMIZE(rc);
+        BENCH_DO_NOT_OPTIMIZE(r.headers);
+        ops++;
+    }
+    return ops;
+}
+
+/* 2. CSV to binary records */
+#define CSV_ROWS 4096
+
+typedef struct
+{
+    unsigned long id;
+    char sku[12];
+    double price;
+    long qty;
+    double lat;
+    double lon;
+} csv_record;
+
+typedef struct
+{
+    FILE *fp;
+    char *line;
+    size_t cap;
+    csv_record *records;
+    size_t next;
+} csv_state;
+
+static void init_csv(void **state)
+{
+    csv_state *st = xmalloc(sizeof(*st));
+    memset(st, 0, sizeof(*st));
+    *state = st;
+    st->fp = tmpfile();
+    if (!st->fp)
+    {
+        bench_skip("tmpfile failed");
+        return;
+    }
+    for (size_t i = 0; i < CSV_ROWS; i++)
+    {
+        char sku[12];
+        app_word(sku, 6, 10);
+        fprintf(st->fp, "%zu,%s,%.2f,%u,%.6f,%.6f\n", 100000 + i, sku,
+                (double)bench_rand_range(1, 100000) / 100.0, (unsigned)bench_rand_range(0, 500),
+                (double)bench_rand_range(0, 180000000) / 1e6 - 90.0,
+                (double)bench_rand_range(0, 360000000) / 1e6 - 180.0);
+    }
+    rewind(st->fp);
+    st->records = xmalloc(CSV_ROWS * sizeof(csv_record));
+}
+
+static void cleanup_csv(void *state)
+{
+    csv_state *st = (csv_state *)state;
+    if (st->fp)
+        fclose(st->fp);
+    free(st->line);
+    free(st->records);
+    free(st);
+}
+
+/* One op reads and converts one line; at the end of the file it starts over */
+static size_t run_csv_load(void *state, size_t iters)
+{
+    csv_state *st = (csv_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        ssize_t len = getline(&st->line, &st->cap, st->fp);
+        if (len < 0)
+        {
+            rewind(st->fp);
+            st->next = 0;
+            len = getline(&st->line, &st->cap, st->fp);
+            if (len < 0)
+                break;
+        }
+        csv_record *rec = &st->records[st->next++ & (CSV_ROWS - 1)];
+        char *p = st->line, *end;
+        rec->id = strtoul(p, &end, 10);
+        p = end + 1;
+        end = strchr(p, ',');
+        if (!end)
+            break;
+        size_t n = (size_t)(end - p) < sizeof(rec->sku) - 1 ? (size_t)(end - p) : sizeof(rec->sku) - 1;
+        memcpy(rec->sku, p, n);
+        rec->sku[n] = '\0';
+        rec->price = strtod(end + 1, &end);
+        rec->qty = strtol(end + 1, &end, 10);
+        rec->lat = strtod(end + 1, &end);
+        rec->lon = strtod(end + 1, &end);
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+/* 3. JSON serialization */
+#define JSON_OUT (64 * 1024)
+
+static const char *const TAGS[] = {"new", "sale", "featured", "clearance", "limited", "bundle", "eco", "imported"};
+
+typedef struct
+{
+    unsigned long long id;
+    char name[24];
+    double score;
+    unsigned tags[3];
+    unsigned ntags;
+    int active;
+} json_record;
+
+typedef struct
+{
+    json_record records[APP_POOL];
+    char *out;
+    size_t pos;
+} json_state;
+
+static void init_json(void **state)
+{
+    json_state *st = xmalloc(sizeof(*st));
+    for (size_t i = 0; i < APP_POOL; i++)
+    {
+        json_record *r = &st->records[i];
+        r->id = bench_rand() % 10000000000ull;
+        app_word(r->name, 4, 20);
+        r->score = (double)bench_rand_range(0, 100000) / 1000.0;
+        r->ntags = (unsigned)bench_rand_range(0, 3);
+        for (unsigned k = 0; k < 3; k++)
+            r->tags[k] = (unsigned)(bench_rand() % 8);
+        r->active = (int)(bench_rand() % 2);
+    }
+    st->out = xmalloc(JSON_OUT);
+    st->pos = 0;
+    *state = st;
+}
+
+static void cleanup_json(void *state)
+{
+    json_state *st = (json_state *)state;
+    free(st->out);
+    free(st);
+}
+
+static inline char *put(char *p, const char *s, size_t n)
+{
+    memcpy(p, s, n);
+    return p + n;
+}
+#define PUT_LITERAL(p, s) put(p, s, sizeof(s) - 1)
+
+/* Generated names are plain letters, so no string needs escaping */
+static size_t json_serialize(char *out, const json_record *r)
+{
+    char *p = out;
+    p = PUT_LITERAL(p, "{\"id\":");
+    p += snprintf(p, 24, "%llu", r->id);
+    p = PUT_LITERAL(p, ",\"name\":\"");
+    p = put(p, r->name, strlen(r->name));
+    p = PUT_LITERAL(p, "\",\"score\":");
+    p += snprintf(p, 32, "%.3f", r->score);
+    p = PUT_LITERAL(p, ",\"tags\":[");
+    for (unsigned k = 0; k < r->ntags; k++)
+    {
+        if (k)
+            *p++ = ',';
+        *p++ = '"';
+        p = put(p, TAGS[r->tags[k]], strlen(TAGS[r->tags[k]]));
+        *p++ = '"';
+    }
+    p = PUT_LITERAL(p, "],\"active\":");
+    p = r->active ? PUT_LITERAL(p, "true") : PUT_LITERAL(p, "false");
+    p = PUT_LITERAL(p, "}\n");
+    return (size_t)(p - out);
+}
+
+/* Appends to a 64 KiB buffer, starting over when it is nearly full */
+static size_t run_json_serialize(void *state, size_t iters)
+{
+    json_state *st = (json_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        if (st->pos > JSON_OUT - 512)
+            st->pos = 0;
+        st->pos += json_serialize(st->out + st->pos, &st->records[i & (APP_POOL - 1)]);
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+/* 4. Key-value store */
+#define KV_KEYS 8192    /* power of two */
+#define KV_BUCKETS 4096 /* power of two */
+#define KV_COMPACT 1024 /* requests between compactions */
+
+typedef struct kv_node
+{
+    struct kv_node *next;
+    uint64_t hash;
+    size_t klen;
+    size_t vlen;
+    char data[]; /* key, then value */
+} kv_node;
+
+typedef struct
+{
+    kv_node *buckets[KV_BUCKETS];
+    size_t count;
+    char keys[KV_KEYS][16];
+    uint64_t hashes[KV_KEYS];
+    unsigned short vlen[KV_KEYS];
+    unsigned char kind[KV_KEYS]; /* per request: 0..5 get, 6..8 put, 9 delete */
+    unsigned short target[KV_KEYS];
+    char value[256];
+    size_t since_compact;
+} kv_state;
+
+static uint64_t fnv1a(const char *s, size_t n)
+{
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ (unsigned char)s[i]) * 1099511628211ull;
+    return h;
+}
+
+static kv_node **kv_find(kv_state *st, size_t k)
+{
+    size_t klen = strlen(st->keys[k]);
+    kv_node **link = &st->buckets[st->hashes[k] & (KV_BUCKETS - 1)];
+    while (*link && ((*link)->hash != st->hashes[k] || (*link)->klen != klen ||
+                     memcmp((*link)->data, st->keys[k], klen) != 0))
+        link = &(*link)->next;
+    return link;
+}
+
+/* Inserts or replaces key k with a value of its own length */
+static void kv_put(kv_state *st, size_t k)
+{
+    size_t klen = strlen(st->keys[k]), vlen = st->vlen[k];
+    kv_node *n = malloc(sizeof(kv_node) + klen + vlen);
+    if (!n)
+        bench_out_of_memory();
+    n->hash = st->hashes[k];
+    n->klen = klen;
+    n->vlen = vlen;
+    memcpy(n->data, st->keys[k], klen);
+    memcpy(n->data + klen, st->value, vlen);
+    kv_node **link = kv_find(st, k);
+    if (*link)
+    {
+        n->next = (*link)->next;
+        free(*link);
+    }
+    else
+    {
+        n->next = NULL;
+        st->count++;
+    }
+    *link = n;
+}
+
+static int cmp_node(const void *a, const void *b)
+{
+    const kv_node *x = *(kv_node *const *)a, *y = *(kv_node *const *)b;
+    size_t n = x->klen < y->klen ? x->klen : y->klen;
+    int c = memcmp(x->data, y->data, n);
+    return c ? c : (x->klen > y->klen) - (x->klen < y->klen);
+}
+
+/*
+ * Compaction as an LSM store would flush: sort the live entries by key and
+ * relink every bucket in key order.
+ */
+static void kv_compact(kv_state *st)
+{
+    kv_node **all = xmalloc(st->count * sizeof(*all));
+    size_t n = 0;
+    for (size_t b = 0; b < KV_BUCKETS; b++)
+        for (kv_node *p = st->buckets[b]; p; p = p->next)
+            all[n++] = p;
+    qsort(all, n, sizeof(*all), cmp_node);
+    memset(st->buckets, 0, sizeof(st->buckets));
+    for (size_t i = n; i-- > 0;)
+    {
+        kv_node **head = &st->buckets[all[i]->hash & (KV_BUCKETS - 1)];
+        all[i]->next = *head;
+        *head = all[i];
+    }
+    free(all);
+}
+
+static void init_kv(void **state)
+{
+    kv_state *st = xmalloc(sizeof(*st));
+    memset(st->buckets, 0, sizeof(st->buckets));
+    st->count = 0;
+    st->since_compact = 0;
+    for (size_t i = 0; i < KV_KEYS; i++)
+    {
+        /* The index in the low digits keeps keys distinct */
+        int len = snprintf(st->keys[i], sizeof(st->keys[i]), "user:%zu",
+                           (size_t)(bench_rand() % 1000000) * KV_KEYS + i);
+        st->hashes[i] = fnv1a(st->keys[i], (size_t)len);
+        st->vlen[i] = (unsigned short)bench_rand_range(16, sizeof(st->value));
+        st->kind[i] = (unsigned char)(bench_rand() % 10);
+        st->target[i] = (unsigned short)(bench_rand() % KV_KEYS);
+    }
+    for (size_t i = 0; i < sizeof(st->value); i++)
+        st->value[i] = (char)('a' + i % 26);
+    for (size_t i = 0; i < KV_KEYS; i += 2)
+        kv_put(st, i);
+    *state = st;
+}
+
+static void cleanup_kv(void *state)
+{
+    kv_state *st = (kv_state *)state;
+    for (size_t b = 0; b < KV_BUCKETS; b++)
+    {
+        kv_node *p = st->buckets[b];
+        while (p)
+        {
+            kv_node *next = p->next;
+            free(p);
+            p = next;
+        }
+    }
+    free(st);
+}
+
+/* 60% get, 30% put, 10% delete on a uniformly chosen key */
+static size_t run_kv_store(void *state, size_t iters)
+{
+    kv_state *st = (kv_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t r = i & (KV_KEYS - 1);
+        size_t k = st->target[r];
+        if (st->kind[r] < 6)
+        {
+            kv_node *n = *kv_find(st, k);
+            BENCH_DO_NOT_OPTIMIZE(n);
+        }
+        else if (st->kind[r] < 9)
+            kv_put(st, k);
+        else
+        {
+            kv_node **link = kv_find(st, k);
+            if (*link)
+            {
+                kv_node *n = *link;
+                *link = n->next;
+                free(n);
+                st->count--;
+            }
+        }
+        if (++st->since_compact == KV_COMPACT)
+        {
+            kv_compact(st);
+            st->since_compact = 0;
+        }
+        ops++;
+    }
+    return ops;
+}
+
+/* 5. Access-log formatting */
+typedef struct
+{
+    FILE *out;
+    time_t t[APP_POOL];
+    unsigned char ip[APP_POOL][4];
+    char path[APP_POOL][48];
+    unsigned method[APP_POOL];
+    int status[APP_POOL];
+    size_t bytes[APP_POOL];
+} log_state;
+
+static void init_log(void **state)
+{
+    static const int STATUS[] = {200, 200, 200, 200, 201, 204, 301, 304, 404, 500};
+    log_state *st = xmalloc(sizeof(*st));
+    *state = st;
+    st->out = fopen("/dev/null", "w");
+    if (!st->out)
+    {
+        bench_skip("cannot open /dev/null");
+        return;
+    }
+    for (size_t i = 0; i < APP_POOL; i++)
+    {
+        char word[24];
+        app_word(word, 3, 16);
+        st->t[i] = (time_t)(1700000000 + bench_rand() % 100000000);
+        for (int k = 0; k < 4; k++)
+            st->ip[i][k] = (unsigned char)bench_rand();
+        snprintf(st->path[i], sizeof(st->path[i]), "/static/%s/%u.html", word, (unsigned)(bench_rand() % 1000));
+        st->method[i] = (unsigned)(bench_rand() % 5);
+        st->status[i] = STATUS[bench_rand() % 10];
+        st->bytes[i] = bench_rand_range(0, 1 << 20);
+    }
+}
+
+static void cleanup_log(void *state)
+{
+    log_state *st = (log_state *)state;
+    if (st->out)
+        fclose(st->out);
+    free(st);
+}
+
+/* Common Log Format lines to a fully buffered stream on /dev/null */
+static size_t run_log_format(void *state, size_t iters)
+{
+    log_state *st = (log_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t k = i & (APP_POOL - 1);
+        struct tm tm;
+        char stamp[32];
+        gmtime_r(&st->t[k], &tm);
+        strftime(stamp, sizeof(stamp), "%d/%b/%Y:%H:%M:%S +0000", &tm);
+        int r = fprintf(st->out, "%u.%u.%u.%u - - [%s] \"%s %s HTTP/1.1\" %d %zu\n",
+                        st->ip[k][0], st->ip[k][1], st->ip[k][2], st->ip[k][3], stamp,
+                        METHODS[st->method[k]], st->path[k], st->status[k], st->bytes[k]);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+
+static const Benchmark app_benchmarks[] = {
+    {"app_http_parse", init_http, run_http_parse, free},
+    {"app_csv_load", init_csv, run_csv_load, cleanup_csv},
+    {"app_json_serialize", init_json, run_json_serialize, cleanup_json},
+    {"app_kv_store", init_kv, run_kv_store, cleanup_kv},
+    {"app_log_format", init_log, run_log_format, cleanup_log},
+};
+BENCH_REGISTER_TABLE(app_benchmarks)
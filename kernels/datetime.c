@@ -0,0 +1,220 @@
+#define _GNU_SOURCE
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../libcbench.h"
+
+/*
+ * Time conversion and formatting as used per access-log line: gmtime_r,
+ * localtime_r under three TZ settings, mktime, strftime/strptime with the
+ * Common Log Format and ISO 8601 layouts, and tzset. Timestamps are random
+ * seconds in 2000..2040.
+ *
+ * The zone-file variants use the bundled tzdata/America/New_York (resolved
+ * from the working directory; BENCH_TZFILE overrides it), falling back to the
+ * equivalent POSIX rule string when the file is missing.
+ */
+
+#define TIME_POOL 1024 /* power of two */
+#define TIME_MIN 946684800ll  /* 2000-01-01 */
+#define TIME_MAX 2208988800ll /* 2040-01-01 */
+
+static const char CLF_FORMAT[] = "%d/%b/%Y:%H:%M:%S %z";
+static const char ISO_FORMAT[] = "%Y-%m-%dT%H:%M:%S%z";
+/* strptime's %z is not portable, so parsing stops before the offset */
+static const char CLF_PARSE[] = "%d/%b/%Y:%H:%M:%S";
+static const char ISO_PARSE[] = "%Y-%m-%dT%H:%M:%S";
+
+static char zone_tz[PATH_MAX + 2];
+static char *saved_tz;
+static int tz_saved;
+
+/* TZ value selecting the bundled zone file */
+static const char *zone(void)
+{
+    if (zone_tz[0])
+        return zone_tz;
+    const char *file = getenv("BENCH_TZFILE");
+    char path[PATH_MAX];
+    if (realpath(file ? file : "tzdata/America/New_York", path))
+    {
+        snprintf(zone_tz, sizeof(zone_tz), ":%s", path);
+    }
+    else
+    {
+        fprintf(stderr, "note: zone file not found, using a POSIX TZ rule instead\n");
+        snprintf(zone_tz, sizeof(zone_tz), "EST5EDT,M3.2.0,M11.1.0");
+    }
+    return zone_tz;
+}
+
+/* Sets TZ (NULL unsets it) and reloads it; the first call remembers the original */
+static void set_tz(const char *tz)
+{
+    if (!tz_saved)
+    {
+        const char *orig = getenv("TZ");
+        saved_tz = orig ? strdup(orig) : NULL;
+        tz_saved = 1;
+    }
+    if (tz)
+        setenv("TZ", tz, 1);
+    else
+        unsetenv("TZ");
+    tzset();
+}
+
+typedef struct
+{
+    time_t t[TIME_POOL];
+    struct tm tm[TIME_POOL];
+    char text[TIME_POOL][40];
+} time_state;
+
+/* Pool of timestamps plus their broken-down (local) time and `format` text */
+static void init_times(void **state, const char *tz, const char *format)
+{
+    set_tz(tz);
+    time_state *st = xmalloc(sizeof(*st));
+    for (size_t i = 0; i < TIME_POOL; i++)
+    {
+        st->t[i] = (time_t)(TIME_MIN + (long long)bench_rand_range(0, TIME_MAX - TIME_MIN));
+        localtime_r(&st->t[i], &st->tm[i]);
+        if (format)
+            strftime(st->text[i], sizeof(st->text[i]), format, &st->tm[i]);
+    }
+    *state = st;
+}
+static void init_time_utc(void **state) { init_times(state, "UTC", NULL); }
+static void init_time_unset(void **state) { init_times(state, NULL, NULL); }
+static void init_time_zone(void **state) { init_times(state, zone(), NULL); }
+static void init_time_clf(void **state) { init_times(state, zone(), CLF_FORMAT); }
+static void init_time_iso(void **state) { init_times(state, zone(), ISO_FORMAT); }
+
+static void cleanup_times(void *state)
+{
+    free(state);
+    set_tz(saved_tz);
+}
+
+static size_t run_gmtime_r(void *state, size_t iters)
+{
+    time_state *st = (time_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct tm tm;
+        BENCH_DO_NOT_OPTIMIZE(gmtime_r(&st->t[i & (TIME_POOL - 1)], &tm));
+        BENCH_DO_NOT_OPTIMIZE(tm.tm_mday);
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_localtime_r(void *state, size_t iters)
+{
+    time_state *st = (time_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct tm tm;
+        BENCH_DO_NOT_OPTIMIZE(localtime_r(&st->t[i & (TIME_POOL - 1)], &tm));
+        BENCH_DO_NOT_OPTIMIZE(tm.tm_mday);
+        ops++;
+    }
+    return ops;
+}
+
+/* mktime normalizes its argument, so each call gets a fresh copy (isdst unknown) */
+static size_t run_mktime(void *state, size_t iters)
+{
+    time_state *st = (time_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct tm tm = st->tm[i & (TIME_POOL - 1)];
+        tm.tm_isdst = -1;
+        BENCH_DO_NOT_OPTIMIZE(mktime(&tm));
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_strftime(void *state, size_t iters, const char *format)
+{
+    time_state *st = (time_state *)state;
+    size_t ops = 0;
+    char buf[64];
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(strftime(buf, sizeof(buf), format, &st->tm[i & (TIME_POOL - 1)]));
+        ops++;
+    }
+    return ops;
+}
+static size_t run_strftime_clf(void *state, size_t iters) { return run_strftime(state, iters, CLF_FORMAT); }
+static size_t run_strftime_iso(void *state, size_t iters) { return run_strftime(state, iters, ISO_FORMAT); }
+
+static size_t run_strptime(void *state, size_t iters, const char *format)
+{
+    time_state *st = (time_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct tm tm;
+        memset(&tm, 0, sizeof(tm));
+        BENCH_DO_NOT_OPTIMIZE(strptime(st->text[i & (TIME_POOL - 1)], format, &tm));
+        BENCH_DO_NOT_OPTIMIZE(tm.tm_sec);
+        ops++;
+    }
+    return ops;
+}
+static size_t run_strptime_clf(void *state, size_t iters) { return run_strptime(state, iters, CLF_PARSE); }
+static size_t run_strptime_iso(void *state, size_t iters) { return run_strptime(state, iters, ISO_PARSE); }
+
+/* tzset with TZ unchanged: the check both libcs do before using a cached zone */
+static size_t run_tzset_cached(void *state, size_t iters)
+{
+    (void)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        tzset();
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+/* One op switches TZ between the zone file and UTC, so every tzset reloads */
+static size_t run_tzset_reload(void *state, size_t iters)
+{
+    (void)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        setenv("TZ", i & 1 ? "UTC" : zone(), 1);
+        tzset();
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+static const Benchmark datetime_benchmarks[] = {
+    {"gmtime_r", init_time_utc, run_gmtime_r, cleanup_times},
+    {"localtime_r_unset", init_time_unset, run_localtime_r, cleanup_times},
+    {"localtime_r_utc", init_time_utc, run_localtime_r, cleanup_times},
+    {"localtime_r_zone", init_time_zone, run_localtime_r, cleanup_times},
+    {"mktime_zone", init_time_zone, run_mktime, cleanup_times},
+    {"strftime_clf", init_time_zone, run_strftime_clf, cleanup_times},
+    {"strftime_iso8601", init_time_zone, run_strftime_iso, cleanup_times},
+    {"strptime_clf", init_time_clf, run_strptime_clf, cleanup_times},
+    {"strptime_iso8601", init_time_iso, run_strptime_iso, cleanup_times},
+    {"tzset_cached", init_time_zone, run_tzset_cached, cleanup_times},
+    {"tzset_reload", init_time_zone, run_tzset_reload, cleanup_times, BENCH_F_NOT_MT},
+};
+BENCH_REGISTER_TABLE(datetime_benchmarks)
@@ -0,0 +1,383 @@
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <link.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libcbench.h"
+
+/*
+ * Process environment and dynamic linking: getenv/setenv with ENV_VARS extra
+ * variables in the environment (as in a container with a large injected
+ * environment), dlopen/dlclose and dlsym on the plugin run.sh builds from
+ * plugins/bench_plugin.c, dlsym through the global scope, and full
+ * dl_iterate_phdr walks. Every benchmark also has a latency kernel for -L.
+ *
+ * The plugin path comes from BENCH_PLUGIN. Without it, or where dlopen is
+ * unavailable (statically linked musl), the dl* benchmarks are skipped. musl
+ * never unloads libraries, so its dlclose is a no-op and dlopen_dlclose only
+ * finds the already loaded object again; glibc maps and relocates it anew.
+ */
+
+#define ENV_VARS 1024
+#define ENV_POOL 1024 /* power of two */
+#define SYM_POOL 256  /* power of two; the plugin exports 256 functions */
+
+typedef struct
+{
+    char *names[ENV_VARS];
+    char *missing[ENV_POOL]; /* names that are not in the environment */
+    unsigned short order[ENV_POOL];
+    char values[2][64];
+} env_state;
+
+/* Random upper-case name of 4..20 characters; the suffix keeps names distinct */
+static char *env_name(size_t i, const char *suffix)
+{
+    char buf[48];
+    size_t len = bench_rand_range(4, 20);
+    for (size_t k = 0; k < len; k++)
+        buf[k] = (char)('A' + bench_rand() % 26);
+    snprintf(buf + len, sizeof(buf) - len, "_%zu%s", i, suffix);
+    return strdup(buf);
+}
+
+static void init_env(void **state)
+{
+    env_state *st = xmalloc(sizeof(*st));
+    for (size_t i = 0; i < ENV_VARS; i++)
+    {
+        char value[64];
+        size_t len = bench_rand_range(8, 48);
+        for (size_t k = 0; k < len; k++)
+            value[k] = (char)('a' + bench_rand() % 26);
+        value[len] = '\0';
+        st->names[i] = env_name(i, "");
+        if (!st->names[i] || setenv(st->names[i], value, 1) != 0)
+            bench_out_of_memory();
+    }
+    for (size_t i = 0; i < ENV_POOL; i++)
+    {
+        st->missing[i] = env_name(i, "_UNSET");
+        if (!st->missing[i])
+            bench_out_of_memory();
+        st->order[i] = (unsigned short)bench_rand_range(0, ENV_VARS - 1);
+    }
+    snprintf(st->values[0], sizeof(st->values[0]), "/usr/local/bin:/usr/bin:/bin");
+    snprintf(st->values[1], sizeof(st->values[1]), "/opt/service/bin:/usr/bin:/bin");
+    *state = st;
+}
+
+static void cleanup_env(void *state)
+{
+    env_state *st = (env_state *)state;
+    for (size_t i = 0; i < ENV_VARS; i++)
+    {
+        unsetenv(st->names[i]);
+        free(st->names[i]);
+    }
+    for (size_t i = 0; i < ENV_POOL; i++)
+        free(st->missing[i]);
+    free(st);
+}
+
+static size_t run_getenv_hit(void *state, size_t iters)
+{
+    env_state *st = (env_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(getenv(st->names[st->order[i & (ENV_POOL - 1)]]));
+        ops++;
+    }
+    return ops;
+}
+
+static size_t lat_getenv_hit(void *state, size_t iters, bench_hist *h)
+{
+    env_state *st = (env_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        char *v = getenv(st->names[st->order[i & (ENV_POOL - 1)]]);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(v);
+        ops++;
+    }
+    return ops;
+}
+
+/* A miss scans the whole environment */
+static size_t run_getenv_miss(void *state, size_t iters)
+{
+    env_state *st = (env_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(getenv(st->missing[i & (ENV_POOL - 1)]));
+        ops++;
+    }
+    return ops;
+}
+
+static size_t lat_getenv_miss(void *state, size_t iters, bench_hist *h)
+{
+    env_state *st = (env_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        char *v = getenv(st->missing[i & (ENV_POOL - 1)]);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(v);
+        ops++;
+    }
+    return ops;
+}
+
+/*
+ * Overwrites an existing variable, alternating between two values: glibc
+ * keeps every "name=value" string it ever built and reuses it, so a bounded
+ * set of values keeps its memory bounded too.
+ */
+static size_t run_setenv_overwrite(void *state, size_t iters)
+{
+    env_state *st = (env_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        int r = setenv(st->names[st->order[i & (ENV_POOL - 1)]], st->values[(i >> 10) & 1], 1);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+
+static size_t lat_setenv_overwrite(void *state, size_t iters, bench_hist *h)
+{
+    env_state *st = (env_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        int r = setenv(st->names[st->order[i & (ENV_POOL - 1)]], st->values[(i >> 10) & 1], 1);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+
+typedef struct
+{
+    const char *path;
+    void *handle;
+    char names[SYM_POOL][16];
+} dl_state;
+
+/* Libc symbols resolved through the global scope */
+static const char *const LIBC_SYMBOLS[] = {
+    "strlen", "memcpy", "malloc", "free", "printf", "getenv", "qsort", "fopen",
+    "strtol", "snprintf", "pthread_create", "clock_gettime", "open", "read", "write", "close",
+};
+
+/* Loads the plugin to check it works; `keep` leaves it open in the state */
+static void init_plugin(void **state, int keep)
+{
+    dl_state *st = xmalloc(sizeof(*st));
+    memset(st, 0, sizeof(*st));
+    *state = st;
+    st->path = getenv("BENCH_PLUGIN");
+    if (!st->path)
+    {
+        bench_skip("BENCH_PLUGIN is not set (run.sh builds the plugin)");
+        return;
+    }
+    st->handle = dlopen(st->path, RTLD_NOW | RTLD_LOCAL);
+    if (!st->handle)
+    {
+        fprintf(stderr, "note: %s\n", dlerror());
+        bench_skip("cannot dlopen the plugin");
+        return;
+    }
+    if (!keep)
+    {
+        dlclose(st->handle);
+        st->handle = NULL;
+    }
+    for (size_t i = 0; i < SYM_POOL; i++)
+        snprintf(st->names[i], sizeof(st->names[i]), "plugin_fn_%03zx", bench_rand_range(0, SYM_POOL - 1));
+}
+static void init_dlopen(void **state) { init_plugin(state, 0); }
+static void init_dlsym(void **state) { init_plugin(state, 1); }
+
+static void init_dlsym_default(void **state)
+{
+    *state = NULL;
+    if (!dlsym(RTLD_DEFAULT, "strlen"))
+        bench_skip("dlsym(RTLD_DEFAULT) does not work in this binary");
+}
+
+static void cleanup_dl(void *state)
+{
+    dl_state *st = (dl_state *)state;
+    if (st && st->handle)
+        dlclose(st->handle);
+    free(st);
+}
+
+static size_t run_dlopen_dlclose(void *state, size_t iters)
+{
+    dl_state *st = (dl_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        void *handle = dlopen(st->path, RTLD_NOW | RTLD_LOCAL);
+        BENCH_DO_NOT_OPTIMIZE(handle);
+        if (handle)
+            dlclose(handle);
+        ops++;
+    }
+    return ops;
+}
+
+static size_t lat_dlopen_dlclose(void *state, size_t iters, bench_hist *h)
+{
+    dl_state *st = (dl_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        void *handle = dlopen(st->path, RTLD_NOW | RTLD_LOCAL);
+        if (handle)
+            dlclose(handle);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(handle);
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_dlsym_plugin(void *state, size_t iters)
+{
+    dl_state *st = (dl_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(dlsym(st->handle, st->names[i & (SYM_POOL - 1)]));
+        ops++;
+    }
+    return ops;
+}
+
+static size_t lat_dlsym_plugin(void *state, size_t iters, bench_hist *h)
+{
+    dl_state *st = (dl_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        void *sym = dlsym(st->handle, st->names[i & (SYM_POOL - 1)]);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(sym);
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_dlsym_default(void *state, size_t iters)
+{
+    (void)state;
+    const size_t n = sizeof(LIBC_SYMBOLS) / sizeof(LIBC_SYMBOLS[0]);
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(dlsym(RTLD_DEFAULT, LIBC_SYMBOLS[i % n]));
+        ops++;
+    }
+    return ops;
+}
+
+static size_t lat_dlsym_default(void *state, size_t iters, bench_hist *h)
+{
+    (void)state;
+    const size_t n = sizeof(LIBC_SYMBOLS) / sizeof(LIBC_SYMBOLS[0]);
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        void *sym = dlsym(RTLD_DEFAULT, LIBC_SYMBOLS[i % n]);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(sym);
+        ops++;
+    }
+    return ops;
+}
+
+static int count_phdrs(struct dl_phdr_info *info, size_t size, void *data)
+{
+    (void)size;
+    *(size_t *)data += info->dlpi_phnum;
+    return 0;
+}
+
+static int count_objects(struct dl_phdr_info *info, size_t size, void *data)
+{
+    (void)info;
+    (void)size;
+    ++*(size_t *)data;
+    return 0;
+}
+
+/* The number of loaded objects sets the cost of a walk */
+static void init_phdr(void **state)
+{
+    size_t objects = 0;
+    dl_iterate_phdr(count_objects, &objects);
+    bench_metric("objects", (double)objects);
+    *state = NULL;
+}
+
+/* One op is a full walk over every loaded object (as unwinders do) */
+static size_t run_dl_iterate_phdr(void *state, size_t iters)
+{
+    (void)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t phdrs = 0;
+        dl_iterate_phdr(count_phdrs, &phdrs);
+        BENCH_DO_NOT_OPTIMIZE(phdrs);
+        ops++;
+    }
+    return ops;
+}
+
+static size_t lat_dl_iterate_phdr(void *state, size_t iters, bench_hist *h)
+{
+    (void)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t phdrs = 0;
+        uint64_t t0 = bench_tsc_begin();
+        dl_iterate_phdr(count_phdrs, &phdrs);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(phdrs);
+        ops++;
+    }
+    return ops;
+}
+
+static const Benchmark dynlink_benchmarks[] = {
+    {"getenv_hit", init_env, run_getenv_hit, cleanup_env, 0, lat_getenv_hit},
+    {"getenv_miss", init_env, run_getenv_miss, cleanup_env, 0, lat_getenv_miss},
+    {"setenv_overwrite", init_env, run_setenv_overwrite, cleanup_env, BENCH_F_NOT_MT, lat_setenv_overwrite},
+    {"dlopen_dlclose", init_dlopen, run_dlopen_dlclose, cleanup_dl, 0, lat_dlopen_dlclose},
+    {"dlsym_plugin", init_dlsym, run_dlsym_plugin, cleanup_dl, 0, lat_dlsym_plugin},
+    {"dlsym_default", init_dlsym_default, run_dlsym_default, cleanup_dl, 0, lat_dlsym_default},
+    {"dl_iterate_phdr", init_phdr, run_dl_iterate_phdr, NULL, 0, lat_dl_iterate_phdr},
+};
+BENCH_REGISTER_TABLE(dynlink_benchmarks)
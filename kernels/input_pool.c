@@ -0,0 +1,300 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libcbench.h"
+
+/*
+ * Randomized-input variants (-p) of the fixed-input benchmarks in
+ * benchmark.c. Each draws call i from a pool of POOL_SIZE pre-generated
+ * inputs with varied lengths, mismatch positions and contents, so branch
+ * predictors cannot learn one path. Lengths are capped so each pool stays
+ * within a few MiB (LLC-resident). Names match the fixed variants so the
+ * results line up row by row.
+ */
+
+#define POOL_SIZE 4096 /* power of two */
+#define POOL_MASK (POOL_SIZE - 1)
+
+typedef struct
+{
+    char *arena;
+    size_t used;
+    char *a[POOL_SIZE];
+    char *b[POOL_SIZE];
+    size_t n[POOL_SIZE];
+    char c[POOL_SIZE];
+} pool_state;
+
+static pool_state *pool_new(size_t arena_bytes)
+{
+    pool_state *st = xmalloc(sizeof(*st));
+    st->arena = xmalloc(arena_bytes);
+    st->used = 0;
+    return st;
+}
+
+/* Carves len + 1 bytes from the arena (the pools are sized up front) */
+static char *pool_alloc(pool_state *st, size_t len)
+{
+    char *p = st->arena + st->used;
+    st->used += len + 1;
+    return p;
+}
+
+static void pool_fill(char *p, size_t len, const char *alphabet, size_t alen)
+{
+    for (size_t i = 0; i < len; i++)
+        p[i] = alphabet[bench_rand() % alen];
+    p[len] = '\0';
+}
+
+static void cleanup_pool(void *state)
+{
+    pool_state *st = (pool_state *)state;
+    free(st->arena);
+    free(st);
+}
+
+static const char printable[] =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 _-.,:/";
+
+/* strlen: lengths 0..512 */
+static void init_pool_strlen(void **state)
+{
+    pool_state *st = pool_new((size_t)POOL_SIZE * 513);
+    for (size_t i = 0; i < POOL_SIZE; i++)
+    {
+        size_t len = bench_rand_range(0, 512);
+        st->a[i] = pool_alloc(st, len);
+        pool_fill(st->a[i], len, printable, sizeof(printable) - 1);
+    }
+    *state = st;
+}
+static size_t run_pool_strlen(void *state, size_t iters)
+{
+    pool_state *st = (pool_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(strlen(st->a[i & POOL_MASK]));
+        ops++;
+    }
+    return ops;
+}
+
+/*
+ * String pairs for strcmp/strncmp/memcmp: lengths 1..max_len, a quarter
+ * equal, the rest differing at a uniformly random position; n holds the
+ * length (memcmp) or a limit around it (strncmp).
+ */
+static void init_pool_pairs(void **state, size_t max_len, int limit)
+{
+    pool_state *st = pool_new((size_t)POOL_SIZE * 2 * (max_len + 1));
+    for (size_t i = 0; i < POOL_SIZE; i++)
+    {
+        size_t len = bench_rand_range(1, max_len);
+        st->a[i] = pool_alloc(st, len);
+        st->b[i] = pool_alloc(st, len);
+        pool_fill(st->a[i], len, printable, sizeof(printable) - 1);
+        memcpy(st->b[i], st->a[i], len + 1);
+        if (bench_rand() % 4 != 0)
+        {
+            size_t pos = bench_rand_range(0, len - 1);
+            st->b[i][pos] = st->a[i][pos] == 'x' ? 'y' : 'x';
+        }
+        st->n[i] = limit ? bench_rand_range(1, len + 8) : len;
+    }
+    *state = st;
+}
+static void init_pool_strcmp(void **state) { init_pool_pairs(state, 256, 0); }
+static void init_pool_strncmp(void **state) { init_pool_pairs(state, 512, 1); }
+static void init_pool_memcmp(void **state) { init_pool_pairs(state, 1024, 0); }
+static size_t run_pool_strcmp(void *state, size_t iters)
+{
+    pool_state *st = (pool_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t k = i & POOL_MASK;
+        BENCH_DO_NOT_OPTIMIZE(strcmp(st->a[k], st->b[k]));
+        ops++;
+    }
+    return ops;
+}
+static size_t run_pool_strncmp(void *state, size_t iters)
+{
+    pool_state *st = (pool_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t k = i & POOL_MASK;
+        BENCH_DO_NOT_OPTIMIZE(strncmp(st->a[k], st->b[k], st->n[k]));
+        ops++;
+    }
+    return ops;
+}
+static size_t run_pool_memcmp(void *state, size_t iters)
+{
+    pool_state *st = (pool_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t k = i & POOL_MASK;
+        BENCH_DO_NOT_OPTIMIZE(memcmp(st->a[k], st->b[k], st->n[k]));
+        ops++;
+    }
+    return ops;
+}
+
+/* strchr: lengths 1..1024 over a-z, targets a-z or an absent 'Z' */
+static void init_pool_strchr(void **state)
+{
+    static const char lower[] = "abcdefghijklmnopqrstuvwxyz";
+    pool_state *st = pool_new((size_t)POOL_SIZE * 1025);
+    for (size_t i = 0; i < POOL_SIZE; i++)
+    {
+        size_t len = bench_rand_range(1, 1024);
+        st->a[i] = pool_alloc(st, len);
+        pool_fill(st->a[i], len, lower, sizeof(lower) - 1);
+        st->c[i] = bench_rand() % 8 == 0 ? 'Z' : lower[bench_rand() % 26];
+    }
+    *state = st;
+}
+static size_t run_pool_strchr(void *state, size_t iters)
+{
+    pool_state *st = (pool_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t k = i & POOL_MASK;
+        BENCH_DO_NOT_OPTIMIZE(strchr(st->a[k], st->c[k]));
+        ops++;
+    }
+    return ops;
+}
+
+/*
+ * strstr: haystacks of 64..1024 bytes over a four-letter alphabet (many
+ * partial matches), needles of 2..32 bytes cut from the haystack (found) or
+ * cut and altered at a random position (mostly absent).
+ */
+static void init_pool_strstr(void **state)
+{
+    static const char dna[] = "acgt";
+    pool_state *st = pool_new((size_t)POOL_SIZE * (1025 + 33));
+    for (size_t i = 0; i < POOL_SIZE; i++)
+    {
+        size_t hlen = bench_rand_range(64, 1024);
+        size_t nlen = bench_rand_range(2, 32);
+        st->a[i] = pool_alloc(st, hlen);
+        pool_fill(st->a[i], hlen, dna, 4);
+        st->b[i] = pool_alloc(st, nlen);
+        memcpy(st->b[i], st->a[i] + bench_rand_range(0, hlen - nlen), nlen);
+        st->b[i][nlen] = '\0';
+        if (bench_rand() % 2)
+            st->b[i][bench_rand_range(0, nlen - 1)] = 'x';
+    }
+    *state = st;
+}
+static size_t run_pool_strstr(void *state, size_t iters)
+{
+    pool_state *st = (pool_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t k = i & POOL_MASK;
+        BENCH_DO_NOT_OPTIMIZE(strstr(st->a[k], st->b[k]));
+        ops++;
+    }
+    return ops;
+}
+
+/* atoi: 1..9 digits, optional sign and leading blanks */
+static void init_pool_atoi(void **state)
+{
+    pool_state *st = pool_new((size_t)POOL_SIZE * 16);
+    for (size_t i = 0; i < POOL_SIZE; i++)
+    {
+        char tmp[16];
+        size_t len = 0;
+        for (size_t sp = bench_rand() % 3; sp > 0; sp--)
+            tmp[len++] = bench_rand() % 2 ? ' ' : '\t';
+        if (bench_rand() % 3 == 0)
+            tmp[len++] = bench_rand() % 2 ? '-' : '+';
+        size_t digits = bench_rand_range(1, 9);
+        tmp[len++] = (char)('1' + bench_rand() % 9);
+        for (size_t d = 1; d < digits; d++)
+            tmp[len++] = (char)('0' + bench_rand() % 10);
+        st->a[i] = pool_alloc(st, len);
+        memcpy(st->a[i], tmp, len);
+        st->a[i][len] = '\0';
+    }
+    *state = st;
+}
+static size_t run_pool_atoi(void *state, size_t iters)
+{
+    pool_state *st = (pool_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(atoi(st->a[i & POOL_MASK]));
+        ops++;
+    }
+    return ops;
+}
+
+/* strtod: integers, fixed-point, exponent and long-mantissa forms */
+static void init_pool_strtod(void **state)
+{
+    pool_state *st = pool_new((size_t)POOL_SIZE * 40);
+    for (size_t i = 0; i < POOL_SIZE; i++)
+    {
+        char tmp[40];
+        double mant = (double)(bench_rand() % 100000000) / (double)(1 + bench_rand() % 10000);
+        int n;
+        switch (bench_rand() % 4)
+        {
+        case 0:
+            n = snprintf(tmp, sizeof(tmp), "%llu", (unsigned long long)(bench_rand() % 1000000000));
+            break;
+        case 1:
+            n = snprintf(tmp, sizeof(tmp), "%.*f", (int)(bench_rand() % 7), mant);
+            break;
+        case 2:
+            n = snprintf(tmp, sizeof(tmp), "%.*e", (int)(bench_rand() % 10), mant);
+            break;
+        default:
+            n = snprintf(tmp, sizeof(tmp), "%.17g", mant * 1e-5);
+            break;
+        }
+        st->a[i] = pool_alloc(st, (size_t)n);
+        memcpy(st->a[i], tmp, (size_t)n + 1);
+    }
+    *state = st;
+}
+static size_t run_pool_strtod(void *state, size_t iters)
+{
+    pool_state *st = (pool_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        char *end;
+        BENCH_DO_NOT_OPTIMIZE(strtod(st->a[i & POOL_MASK], &end));
+        ops++;
+    }
+    return ops;
+}
+
+static const Benchmark pool_benchmarks[] = {
+    {"strlen", init_pool_strlen, run_pool_strlen, cleanup_pool, BENCH_F_POOL, .bytes = 128},
+    {"strcmp", init_pool_strcmp, run_pool_strcmp, cleanup_pool, BENCH_F_POOL, .bytes = 64},
+    {"strncmp", init_pool_strncmp, run_pool_strncmp, cleanup_pool, BENCH_F_POOL, .bytes = 128},
+    {"memcmp", init_pool_memcmp, run_pool_memcmp, cleanup_pool, BENCH_F_POOL, .bytes = 256},
+    {"strchr", init_pool_strchr, run_pool_strchr, cleanup_pool, BENCH_F_POOL},
+    {"strstr_search", init_pool_strstr, run_pool_strstr, cleanup_pool, BENCH_F_POOL, .bytes = 64},
+    {"atoi_parse", init_pool_atoi, run_pool_atoi, cleanup_pool, BENCH_F_POOL},
+    {"strtod_parse", init_pool_strtod, run_pool_strtod, cleanup_pool, BENCH_F_POOL},
+};
+BENCH_REGISTER_TABLE(pool_benchmarks)
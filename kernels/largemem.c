@@ -0,0 +1,151 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libcbench.h"
+
+/*
+ * Large-buffer memcpy/memset/memmove at 256 KiB (L2), 4 MiB (LLC) and
+ * 64 MiB (DRAM) from bench_alloc_large, so -H and -N decide their page size
+ * and NUMA placement, plus malloc_touch_<size>, 128 KiB to 64 MiB: malloc a
+ * block, write one byte per 4 KiB page and free it, i.e. the page-fault cost
+ * of a large heap, where huge pages save 511 of every 512 faults.
+ *
+ * Rows from 4 MiB up report thp_pct, the share of their memory the kernel
+ * backed with transparent huge pages. For malloc_touch_* it is measured on
+ * a 64 MiB malloc in init: glibc and musl both mmap such blocks, and whether
+ * they end up huge depends on alignment and the system THP setting
+ * (/sys/kernel/mm/transparent_hugepage/enabled), not on -H.
+ */
+
+#define BIG_SHIFT 64 /* memcpy destination gap and memmove overlap distance */
+#define BIG_UNIT ((size_t)2 << 20) /* buffers are whole huge pages */
+
+typedef struct
+{
+    unsigned char *buf;
+    size_t len;
+    size_t alloc;
+} big_state;
+
+/* Maps `copies` buffers of len bytes and faults the whole mapping in */
+static void init_big(void **state, size_t len, size_t copies)
+{
+    big_state *st = xmalloc(sizeof(*st));
+    st->len = len;
+    st->alloc = (copies * len + BIG_SHIFT + BIG_UNIT - 1) & ~(BIG_UNIT - 1);
+    size_t thp = bench_thp_bytes();
+    st->buf = bench_alloc_large(st->alloc);
+    memset(st->buf, 0x5a, st->alloc);
+    if (len >= ((size_t)4 << 20))
+        bench_metric("thp_pct", 100.0 * ((double)bench_thp_bytes() - (double)thp) / (double)st->alloc);
+    *state = st;
+}
+
+static void cleanup_big(void *state)
+{
+    big_state *st = (big_state *)state;
+    bench_free_large(st->buf, st->alloc);
+    free(st);
+}
+
+static size_t run_memcpy_big(void *state, size_t iters)
+{
+    big_state *st = (big_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(memcpy(st->buf + st->len + BIG_SHIFT, st->buf, st->len));
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_memset_big(void *state, size_t iters)
+{
+    big_state *st = (big_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        memset(st->buf, (int)(i & 0xff), st->len);
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+/* Overlapping forward move, so it cannot be done front to back */
+static size_t run_memmove_big(void *state, size_t iters)
+{
+    big_state *st = (big_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(memmove(st->buf + BIG_SHIFT, st->buf, st->len));
+        ops++;
+    }
+    return ops;
+}
+
+#define BIG_INITS(tag, len)                                                   \
+    static void init_big2_##tag(void **state) { init_big(state, len, 2); } \
+    static void init_big1_##tag(void **state) { init_big(state, len, 1); }
+BIG_INITS(256k, (size_t)256 << 10)
+BIG_INITS(4m, (size_t)4 << 20)
+BIG_INITS(64m, (size_t)64 << 20)
+
+#define TOUCH_PAGE 4096
+
+/* The block length travels in the state pointer itself */
+static void init_malloc_touch(void **state, size_t len)
+{
+    *state = (void *)len;
+    if (len < ((size_t)4 << 20))
+        return;
+    size_t probe = (size_t)64 << 20;
+    size_t thp = bench_thp_bytes();
+    unsigned char *p = xmalloc(probe);
+    for (size_t i = 0; i < probe; i += TOUCH_PAGE)
+        p[i] = 1;
+    bench_metric("thp_pct", 100.0 * ((double)bench_thp_bytes() - (double)thp) / (double)probe);
+    free(p);
+}
+
+static size_t run_malloc_touch(void *state, size_t iters)
+{
+    size_t len = (size_t)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        unsigned char *p = xmalloc(len);
+        for (size_t k = 0; k < len; k += TOUCH_PAGE)
+            p[k] = (unsigned char)k;
+        BENCH_CLOBBER_MEMORY();
+        free(p);
+        ops++;
+    }
+    return ops;
+}
+
+#define TOUCH_INIT(tag, len) \
+    static void init_touch_##tag(void **state) { init_malloc_touch(state, len); }
+TOUCH_INIT(128k, (size_t)128 << 10)
+TOUCH_INIT(1m, (size_t)1 << 20)
+TOUCH_INIT(8m, (size_t)8 << 20)
+TOUCH_INIT(64m, (size_t)64 << 20)
+
+#define BIG_ENTRIES(tag, len)                                                                           \
+    {"memcpy_big_" #tag, init_big2_##tag, run_memcpy_big, cleanup_big, .bytes = 2 * (len)},         \
+        {"memset_big_" #tag, init_big1_##tag, run_memset_big, cleanup_big, .bytes = (len)},         \
+        {"memmove_big_" #tag, init_big1_##tag, run_memmove_big, cleanup_big, .bytes = 2 * (len)}
+
+static const Benchmark largemem_benchmarks[] = {
+    BIG_ENTRIES(256k, (size_t)256 << 10),
+    BIG_ENTRIES(4m, (size_t)4 << 20),
+    BIG_ENTRIES(64m, (size_t)64 << 20),
+    {"malloc_touch_128k", init_touch_128k, run_malloc_touch, NULL},
+    {"malloc_touch_1m", init_touch_1m, run_malloc_touch, NULL},
+    {"malloc_touch_8m", init_touch_8m, run_malloc_touch, NULL},
+    {"malloc_touch_64m", init_touch_64m, run_malloc_touch, NULL},
+};
+BENCH_REGISTER_TABLE(largemem_benchmarks)
@@ -0,0 +1,455 @@
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <grp.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <pwd.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../libcbench.h"
+
+/*
+ * Name service and address helpers without the network: numeric
+ * getaddrinfo/getnameinfo, inet_pton/inet_ntop, htonl/ntohs, and
+ * /etc/hosts, /etc/passwd and /etc/group lookups. glibc routes the lookups
+ * through NSS (nsswitch.conf, libnss_files), musl parses the files directly.
+ *
+ * The file lookups run against generated files of NSS_ENTRIES entries,
+ * bind-mounted over /etc in a private user and mount namespace (together
+ * with an nsswitch.conf that only lists "files", so nothing reaches DNS).
+ * Without unprivileged user namespaces they fall back to the system files
+ * and look up localhost/root. The mounts are removed again when the last
+ * lookup row is cleaned up, but the process cannot leave the user namespace:
+ * later benchmarks run in it, with the same uid and gid mapped onto
+ * themselves.
+ */
+
+#define NSS_ENTRIES 1000
+#define NAME_POOL 256 /* power of two */
+#define ADDR_POOL 1024 /* power of two */
+
+static int nss_namespace = -1; /* -1: not entered yet */
+static int nss_generated;
+static int nss_users;
+static int nss_noted;
+
+static const char *const NSS_FILES[] = {"hosts", "passwd", "group", "nsswitch.conf"};
+static int nss_mounted[4];
+
+static int write_file(const char *path, const char *text)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+    size_t len = strlen(text);
+    ssize_t w = write(fd, text, len);
+    close(fd);
+    return w == (ssize_t)len ? 0 : -1;
+}
+
+/* Writes one generated file to dir/name and binds it over /etc/name */
+static int mount_generated(const char *dir, const char *name, const char *text)
+{
+    char src[96], dst[64];
+    snprintf(src, sizeof(src), "%s/%s", dir, name);
+    snprintf(dst, sizeof(dst), "/etc/%s", name);
+    if (write_file(src, text) != 0)
+        return -1;
+    int r = access(dst, F_OK) == 0 ? mount(src, dst, NULL, MS_BIND, NULL) : -1;
+    unlink(src);
+    return r;
+}
+
+enum
+{
+    GEN_HOSTS,
+    GEN_PASSWD,
+    GEN_GROUP,
+};
+
+/* `head` followed by NSS_ENTRIES generated lines of the given file */
+static char *generate_text(const char *head, int kind)
+{
+    size_t cap = strlen(head) + (size_t)NSS_ENTRIES * 64;
+    char *text = xmalloc(cap);
+    size_t len = (size_t)snprintf(text, cap, "%s", head);
+    for (int i = 0; i < NSS_ENTRIES; i++)
+    {
+        char *p = text + len;
+        size_t room = cap - len;
+        if (kind == GEN_HOSTS)
+            len += (size_t)snprintf(p, room, "10.0.%d.%d host%04d.bench.test host%04d\n",
+                                    i / 250, i % 250 + 1, i, i);
+        else if (kind == GEN_PASSWD)
+            len += (size_t)snprintf(p, room, "user%04d:x:%d:%d::/home/user%04d:/bin/sh\n",
+                                    i, 10000 + i, 10000 + i, i);
+        else
+            len += (size_t)snprintf(p, room, "group%04d:x:%d:user%04d\n", i, 10000 + i, i);
+    }
+    return text;
+}
+
+/* Private user and mount namespace, entered once per process */
+static int nss_enter_namespace(void)
+{
+    unsigned uid = (unsigned)getuid(), gid = (unsigned)getgid();
+    if (unshare(CLONE_NEWUSER | CLONE_NEWNS) != 0)
+    {
+        fprintf(stderr, "note: no user namespace, name lookups use the system files\n");
+        return 0;
+    }
+    char map[64];
+    snprintf(map, sizeof(map), "%u %u 1\n", uid, uid);
+    write_file("/proc/self/setgroups", "deny");
+    write_file("/proc/self/uid_map", map);
+    snprintf(map, sizeof(map), "%u %u 1\n", gid, gid);
+    write_file("/proc/self/gid_map", map);
+    mount(NULL, "/", NULL, MS_REC | MS_PRIVATE, NULL);
+    return 1;
+}
+
+/* Mounts the generated files for the first lookup row alive */
+static void nss_setup(void)
+{
+    if (nss_users++ > 0)
+        return;
+    if (nss_namespace < 0)
+        nss_namespace = nss_enter_namespace();
+    if (!nss_namespace)
+        return;
+
+    char dir[] = "/tmp/libcbench-nss-XXXXXX";
+    if (!mkdtemp(dir))
+        return;
+    const char *heads[] = {"127.0.0.1 localhost\n::1 localhost ip6-localhost\n",
+                           "root:x:0:0:root:/root:/bin/sh\n", "root:x:0:\n"};
+    int r = 0;
+    for (int k = GEN_HOSTS; k <= GEN_GROUP; k++)
+    {
+        char *text = generate_text(heads[k], k);
+        nss_mounted[k] = mount_generated(dir, NSS_FILES[k], text) == 0;
+        r |= !nss_mounted[k];
+        free(text);
+    }
+    nss_mounted[3] = mount_generated(dir, NSS_FILES[3], "passwd: files\ngroup: files\nhosts: files\n") == 0;
+    rmdir(dir);
+    if (r != 0 && !nss_noted++)
+        fprintf(stderr, "note: cannot mount generated files, name lookups use the system files\n");
+    nss_generated = r == 0;
+}
+
+/* Unmounts them again after the last one, so later rows see the system files */
+static void nss_teardown(void)
+{
+    if (--nss_users > 0)
+        return;
+    for (int k = 0; k < 4; k++)
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/etc/%s", NSS_FILES[k]);
+        if (nss_mounted[k])
+            umount2(path, MNT_DETACH);
+        nss_mounted[k] = 0;
+    }
+    nss_generated = 0;
+}
+
+/* Lookup names: random generated entries, or the fallback name */
+typedef struct
+{
+    char *names[NAME_POOL];
+    char *arena;
+} names_state;
+
+static void init_names(void **state, const char *fmt, const char *fallback)
+{
+    nss_setup();
+    names_state *st = xmalloc(sizeof(*st));
+    st->arena = xmalloc((size_t)NAME_POOL * 32);
+    for (size_t i = 0; i < NAME_POOL; i++)
+    {
+        st->names[i] = st->arena + i * 32;
+        if (nss_generated)
+            snprintf(st->names[i], 32, fmt, (int)bench_rand_range(0, NSS_ENTRIES - 1));
+        else
+            snprintf(st->names[i], 32, "%s", fallback);
+    }
+    if (nss_generated)
+        bench_metric("file_entries", NSS_ENTRIES);
+    *state = st;
+}
+static void init_hosts(void **state) { init_names(state, "host%04d.bench.test", "localhost"); }
+static void init_passwd(void **state) { init_names(state, "user%04d", "root"); }
+static void init_group(void **state) { init_names(state, "group%04d", "root"); }
+static void cleanup_names(void *state)
+{
+    names_state *st = (names_state *)state;
+    free(st->arena);
+    free(st);
+    nss_teardown();
+}
+
+static struct addrinfo *resolve(const char *host, const char *serv, int flags)
+{
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = flags;
+    if (getaddrinfo(host, serv, &hints, &res) != 0)
+        return NULL;
+    return res;
+}
+
+static size_t run_getaddrinfo_hosts(void *state, size_t iters)
+{
+    names_state *st = (names_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct addrinfo *res = resolve(st->names[i & (NAME_POOL - 1)], "80", AI_NUMERICSERV);
+        BENCH_DO_NOT_OPTIMIZE(res);
+        if (res)
+            freeaddrinfo(res);
+        ops++;
+    }
+    return ops;
+}
+static size_t lat_getaddrinfo_hosts(void *state, size_t iters, bench_hist *h)
+{
+    names_state *st = (names_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        struct addrinfo *res = resolve(st->names[i & (NAME_POOL - 1)], "80", AI_NUMERICSERV);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        if (res)
+            freeaddrinfo(res);
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_getpwnam(void *state, size_t iters)
+{
+    names_state *st = (names_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(getpwnam(st->names[i & (NAME_POOL - 1)]));
+        ops++;
+    }
+    return ops;
+}
+static size_t lat_getpwnam(void *state, size_t iters, bench_hist *h)
+{
+    names_state *st = (names_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        struct passwd *pw = getpwnam(st->names[i & (NAME_POOL - 1)]);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(pw);
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_getgrnam(void *state, size_t iters)
+{
+    names_state *st = (names_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(getgrnam(st->names[i & (NAME_POOL - 1)]));
+        ops++;
+    }
+    return ops;
+}
+static size_t lat_getgrnam(void *state, size_t iters, bench_hist *h)
+{
+    names_state *st = (names_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        struct group *gr = getgrnam(st->names[i & (NAME_POOL - 1)]);
+        bench_hist_record(h, bench_tsc_end() - t0);
+        BENCH_DO_NOT_OPTIMIZE(gr);
+        ops++;
+    }
+    return ops;
+}
+
+/* Numeric addresses: text and binary forms of the same random IPv4/IPv6 pool */
+typedef struct
+{
+    char text4[ADDR_POOL][INET_ADDRSTRLEN];
+    char text6[ADDR_POOL][INET6_ADDRSTRLEN];
+    struct in_addr bin4[ADDR_POOL];
+    struct in6_addr bin6[ADDR_POOL];
+    uint32_t words[ADDR_POOL];
+} addr_state;
+
+static void init_addrs(void **state)
+{
+    addr_state *st = xmalloc(sizeof(*st));
+    for (size_t i = 0; i < ADDR_POOL; i++)
+    {
+        uint64_t r = bench_rand();
+        st->words[i] = (uint32_t)r;
+        st->bin4[i].s_addr = (uint32_t)(r >> 32);
+        for (int k = 0; k < 16; k += 8)
+        {
+            uint64_t w = bench_rand();
+            /* Runs of zero groups so inet_ntop has "::" to compress */
+            if (bench_rand() % 2)
+                w &= 0xffff0000ffffull;
+            memcpy(&st->bin6[i].s6_addr[k], &w, 8);
+        }
+        inet_ntop(AF_INET, &st->bin4[i], st->text4[i], INET_ADDRSTRLEN);
+        inet_ntop(AF_INET6, &st->bin6[i], st->text6[i], INET6_ADDRSTRLEN);
+    }
+    *state = st;
+}
+
+static size_t run_inet_pton4(void *state, size_t iters)
+{
+    addr_state *st = (addr_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct in_addr a;
+        BENCH_DO_NOT_OPTIMIZE(inet_pton(AF_INET, st->text4[i & (ADDR_POOL - 1)], &a));
+        BENCH_DO_NOT_OPTIMIZE(a.s_addr);
+        ops++;
+    }
+    return ops;
+}
+static size_t run_inet_pton6(void *state, size_t iters)
+{
+    addr_state *st = (addr_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct in6_addr a;
+        BENCH_DO_NOT_OPTIMIZE(inet_pton(AF_INET6, st->text6[i & (ADDR_POOL - 1)], &a));
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+static size_t run_inet_ntop4(void *state, size_t iters)
+{
+    addr_state *st = (addr_state *)state;
+    size_t ops = 0;
+    char buf[INET_ADDRSTRLEN];
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(inet_ntop(AF_INET, &st->bin4[i & (ADDR_POOL - 1)], buf, sizeof(buf)));
+        ops++;
+    }
+    return ops;
+}
+static size_t run_inet_ntop6(void *state, size_t iters)
+{
+    addr_state *st = (addr_state *)state;
+    size_t ops = 0;
+    char buf[INET6_ADDRSTRLEN];
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_DO_NOT_OPTIMIZE(inet_ntop(AF_INET6, &st->bin6[i & (ADDR_POOL - 1)], buf, sizeof(buf)));
+        ops++;
+    }
+    return ops;
+}
+
+/* One op is an htonl and an ntohs; musl makes these calls, glibc inlines them */
+static size_t run_htonl_ntohs(void *state, size_t iters)
+{
+    addr_state *st = (addr_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint32_t w = st->words[i & (ADDR_POOL - 1)];
+        BENCH_DO_NOT_OPTIMIZE(htonl(w));
+        BENCH_DO_NOT_OPTIMIZE(ntohs((uint16_t)w));
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_getaddrinfo_numeric4(void *state, size_t iters)
+{
+    addr_state *st = (addr_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct addrinfo *res = resolve(st->text4[i & (ADDR_POOL - 1)], "443",
+                                       AI_NUMERICHOST | AI_NUMERICSERV);
+        BENCH_DO_NOT_OPTIMIZE(res);
+        if (res)
+            freeaddrinfo(res);
+        ops++;
+    }
+    return ops;
+}
+static size_t run_getaddrinfo_numeric6(void *state, size_t iters)
+{
+    addr_state *st = (addr_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct addrinfo *res = resolve(st->text6[i & (ADDR_POOL - 1)], "443",
+                                       AI_NUMERICHOST | AI_NUMERICSERV);
+        BENCH_DO_NOT_OPTIMIZE(res);
+        if (res)
+            freeaddrinfo(res);
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_getnameinfo_numeric(void *state, size_t iters)
+{
+    addr_state *st = (addr_state *)state;
+    size_t ops = 0;
+    char host[NI_MAXHOST], serv[NI_MAXSERV];
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(443);
+        sa.sin_addr = st->bin4[i & (ADDR_POOL - 1)];
+        int r = getnameinfo((struct sockaddr *)&sa, sizeof(sa), host, sizeof(host),
+                            serv, sizeof(serv), NI_NUMERICHOST | NI_NUMERICSERV);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+
+static const Benchmark netdb_benchmarks[] = {
+    {"inet_pton4", init_addrs, run_inet_pton4, free},
+    {"inet_pton6", init_addrs, run_inet_pton6, free},
+    {"inet_ntop4", init_addrs, run_inet_ntop4, free},
+    {"inet_ntop6", init_addrs, run_inet_ntop6, free},
+    {"htonl_ntohs", init_addrs, run_htonl_ntohs, free},
+    {"getaddrinfo_numeric4", init_addrs, run_getaddrinfo_numeric4, free},
+    {"getaddrinfo_numeric6", init_addrs, run_getaddrinfo_numeric6, free},
+    {"getnameinfo_numeric", init_addrs, run_getnameinfo_numeric, free},
+    {"getaddrinfo_hosts", init_hosts, run_getaddrinfo_hosts, cleanup_names, 0, lat_getaddrinfo_hosts},
+    {"getpwnam_files", init_passwd, run_getpwnam, cleanup_names, BENCH_F_NOT_MT, lat_getpwnam},
+    {"getgrnam_files", init_group, run_getgrnam, cleanup_names, BENCH_F_NOT_MT, lat_getgrnam},
+};
+BENCH_REGISTER_TABLE(netdb_benchmarks)
@@ -0,0 +1,250 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libcbench.h"
+
+/*
+ * Reference copy and set loops that bound what memcpy/memmove/memset can
+ * reach on this machine: SSE2, AVX2 and AVX-512 loops (four unaligned loads
+ * and stores per iteration) and rep movsb/stosb. Each is compiled for its
+ * instruction set with a target attribute and skipped when cpuid (and XCR0
+ * for the OS side of AVX) says the CPU cannot run it, so the binary works
+ * everywhere its -march allows.
+ *
+ * ref_copy_* runs at 16 KiB (the memcpy/memmove rows), ref_set_* at 32 KiB
+ * (memset), and both at 256 KiB, 4 MiB and 64 MiB (the *_big_* rows), on
+ * buffers from bench_alloc_large. generate.py reports the libc rows as a
+ * percentage of the fastest reference of the same size.
+ */
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+
+enum
+{
+    REF_SSE2,
+    REF_AVX2,
+    REF_AVX512,
+    REF_REP,
+};
+
+static unsigned long long xgetbv0(void)
+{
+    unsigned lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+/* Whether the CPU and the OS support the reference's instruction set */
+static int ref_supported(int impl)
+{
+    unsigned a, b, c, d;
+    if (impl == REF_SSE2 || impl == REF_REP)
+        return 1; /* baseline x86-64 */
+    if (!__get_cpuid(1, &a, &b, &c, &d) || !(c & bit_OSXSAVE))
+        return 0;
+    unsigned long long xcr0 = xgetbv0();
+    if (!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+        return 0;
+    if (impl == REF_AVX2)
+        return (xcr0 & 0x6) == 0x6 && (b & bit_AVX2);
+    /* AVX-512 also needs the opmask and upper ZMM state enabled */
+    return (xcr0 & 0xe6) == 0xe6 && (b & bit_AVX512F);
+}
+
+/* Lengths are multiples of 256 bytes, so the loops need no tails */
+__attribute__((target("sse2"))) static void copy_sse2(void *dst, const void *src, size_t n)
+{
+    __m128i *d = (__m128i *)dst;
+    const __m128i *s = (const __m128i *)src;
+    for (size_t i = 0; i < n / 16; i += 4)
+    {
+        __m128i x0 = _mm_loadu_si128(s + i), x1 = _mm_loadu_si128(s + i + 1);
+        __m128i x2 = _mm_loadu_si128(s + i + 2), x3 = _mm_loadu_si128(s + i + 3);
+        _mm_storeu_si128(d + i, x0);
+        _mm_storeu_si128(d + i + 1, x1);
+        _mm_storeu_si128(d + i + 2, x2);
+        _mm_storeu_si128(d + i + 3, x3);
+    }
+}
+
+__attribute__((target("avx2"))) static void copy_avx2(void *dst, const void *src, size_t n)
+{
+    __m256i *d = (__m256i *)dst;
+    const __m256i *s = (const __m256i *)src;
+    for (size_t i = 0; i < n / 32; i += 4)
+    {
+        __m256i x0 = _mm256_loadu_si256(s + i), x1 = _mm256_loadu_si256(s + i + 1);
+        __m256i x2 = _mm256_loadu_si256(s + i + 2), x3 = _mm256_loadu_si256(s + i + 3);
+        _mm256_storeu_si256(d + i, x0);
+        _mm256_storeu_si256(d + i + 1, x1);
+        _mm256_storeu_si256(d + i + 2, x2);
+        _mm256_storeu_si256(d + i + 3, x3);
+    }
+}
+
+__attribute__((target("avx512f"))) static void copy_avx512(void *dst, const void *src, size_t n)
+{
+    char *d = (char *)dst;
+    const char *s = (const char *)src;
+    for (size_t i = 0; i < n; i += 256)
+    {
+        __m512i x0 = _mm512_loadu_si512(s + i), x1 = _mm512_loadu_si512(s + i + 64);
+        __m512i x2 = _mm512_loadu_si512(s + i + 128), x3 = _mm512_loadu_si512(s + i + 192);
+        _mm512_storeu_si512(d + i, x0);
+        _mm512_storeu_si512(d + i + 64, x1);
+        _mm512_storeu_si512(d + i + 128, x2);
+        _mm512_storeu_si512(d + i + 192, x3);
+    }
+}
+
+static void copy_rep(void *dst, const void *src, size_t n)
+{
+    __asm__ volatile("rep movsb" : "+D"(dst), "+S"(src), "+c"(n) : : "memory");
+}
+
+__attribute__((target("sse2"))) static void set_sse2(void *dst, int c, size_t n)
+{
+    __m128i *d = (__m128i *)dst;
+    __m128i v = _mm_set1_epi8((char)c);
+    for (size_t i = 0; i < n / 16; i += 4)
+    {
+        _mm_storeu_si128(d + i, v);
+        _mm_storeu_si128(d + i + 1, v);
+        _mm_storeu_si128(d + i + 2, v);
+        _mm_storeu_si128(d + i + 3, v);
+    }
+}
+
+__attribute__((target("avx2"))) static void set_avx2(void *dst, int c, size_t n)
+{
+    __m256i *d = (__m256i *)dst;
+    __m256i v = _mm256_set1_epi8((char)c);
+    for (size_t i = 0; i < n / 32; i += 4)
+    {
+        _mm256_storeu_si256(d + i, v);
+        _mm256_storeu_si256(d + i + 1, v);
+        _mm256_storeu_si256(d + i + 2, v);
+        _mm256_storeu_si256(d + i + 3, v);
+    }
+}
+
+__attribute__((target("avx512f"))) static void set_avx512(void *dst, int c, size_t n)
+{
+    char *d = (char *)dst;
+    __m512i v = _mm512_set1_epi32((int)(0x01010101u * (unsigned char)c));
+    for (size_t i = 0; i < n; i += 256)
+    {
+        _mm512_storeu_si512(d + i, v);
+        _mm512_storeu_si512(d + i + 64, v);
+        _mm512_storeu_si512(d + i + 128, v);
+        _mm512_storeu_si512(d + i + 192, v);
+    }
+}
+
+static void set_rep(void *dst, int c, size_t n)
+{
+    __asm__ volatile("rep stosb" : "+D"(dst), "+c"(n) : "a"(c) : "memory");
+}
+
+static void (*const COPY[])(void *, const void *, size_t) = {copy_sse2, copy_avx2, copy_avx512, copy_rep};
+static void (*const SET[])(void *, int, size_t) = {set_sse2, set_avx2, set_avx512, set_rep};
+
+typedef struct
+{
+    unsigned char *buf;
+    size_t len;
+    size_t alloc;
+    int impl;
+} ref_state;
+
+/* copies = 2: source then destination, as in the memcpy rows */
+static void ref_init(void **state, size_t len, size_t copies, int impl)
+{
+    ref_state *st = xmalloc(sizeof(*st));
+    st->len = len;
+    st->alloc = copies * len;
+    st->impl = impl;
+    st->buf = bench_alloc_large(st->alloc);
+    memset(st->buf, 0x5a, st->alloc);
+    *state = st;
+    if (!ref_supported(impl))
+        bench_skip("instruction set not supported by this CPU");
+}
+
+static void cleanup_ref(void *state)
+{
+    ref_state *st = (ref_state *)state;
+    bench_free_large(st->buf, st->alloc);
+    free(st);
+}
+
+static size_t run_ref_copy(void *state, size_t iters)
+{
+    ref_state *st = (ref_state *)state;
+    void (*copy)(void *, const void *, size_t) = COPY[st->impl];
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        copy(st->buf + st->len, st->buf, st->len);
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_ref_set(void *state, size_t iters)
+{
+    ref_state *st = (ref_state *)state;
+    void (*set)(void *, int, size_t) = SET[st->impl];
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        set(st->buf, (int)(i & 0xff), st->len);
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+#define REF_COPY(impl, name, tag, len)                                                         \
+    static void init_ref_copy_##name##_##tag(void **state) { ref_init(state, len, 2, impl); }
+#define REF_SET(impl, name, tag, len)                                                          \
+    static void init_ref_set_##name##_##tag(void **state) { ref_init(state, len, 1, impl); }
+#define REF_SIZE(def, tag, len)              \
+    def(REF_SSE2, sse2, tag, len)            \
+    def(REF_AVX2, avx2, tag, len)            \
+    def(REF_AVX512, avx512, tag, len)        \
+    def(REF_REP, rep, tag, len)
+REF_SIZE(REF_COPY, 16k, (size_t)16 << 10)
+REF_SIZE(REF_SET, 32k, (size_t)32 << 10)
+REF_SIZE(REF_COPY, 256k, (size_t)256 << 10)
+REF_SIZE(REF_SET, 256k, (size_t)256 << 10)
+REF_SIZE(REF_COPY, 4m, (size_t)4 << 20)
+REF_SIZE(REF_SET, 4m, (size_t)4 << 20)
+REF_SIZE(REF_COPY, 64m, (size_t)64 << 20)
+REF_SIZE(REF_SET, 64m, (size_t)64 << 20)
+
+/* rep rows are named after the instruction: ref_copy_movsb_*, ref_set_stosb_* */
+#define REF_ENTRIES(kind, rep, run, tag, nbytes)                                                            \
+    {"ref_" #kind "_sse2_" #tag, init_ref_##kind##_sse2_##tag, run, cleanup_ref, .bytes = (nbytes)},       \
+        {"ref_" #kind "_avx2_" #tag, init_ref_##kind##_avx2_##tag, run, cleanup_ref, .bytes = (nbytes)},   \
+        {"ref_" #kind "_avx512_" #tag, init_ref_##kind##_avx512_##tag, run, cleanup_ref, .bytes = (nbytes)}, \
+        {"ref_" #kind "_" #rep "_" #tag, init_ref_##kind##_rep_##tag, run, cleanup_ref, .bytes = (nbytes)}
+#define REF_COPY_ENTRIES(tag, len) REF_ENTRIES(copy, movsb, run_ref_copy, tag, 2 * (len))
+#define REF_SET_ENTRIES(tag, len) REF_ENTRIES(set, stosb, run_ref_set, tag, (len))
+
+static const Benchmark roofline_benchmarks[] = {
+    REF_COPY_ENTRIES(16k, (size_t)16 << 10),
+    REF_SET_ENTRIES(32k, (size_t)32 << 10),
+    REF_COPY_ENTRIES(256k, (size_t)256 << 10),
+    REF_SET_ENTRIES(256k, (size_t)256 << 10),
+    REF_COPY_ENTRIES(4m, (size_t)4 << 20),
+    REF_SET_ENTRIES(4m, (size_t)4 << 20),
+    REF_COPY_ENTRIES(64m, (size_t)64 << 20),
+    REF_SET_ENTRIES(64m, (size_t)64 << 20),
+};
+BENCH_REGISTER_TABLE(roofline_benchmarks)
+#endif
@@ -0,0 +1,321 @@
+#define _GNU_SOURCE
+#include <malloc.h>
+#include <search.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libcbench.h"
+
+/*
+ * <search.h> containers: tsearch/tfind/tdelete (glibc uses a red-black tree,
+ * musl an AVL tree), hsearch_r and lsearch/lfind, with 1e3..1e6 integer or
+ * string keys. One operation is one insert, lookup or delete; lookups and
+ * deletes visit the keys in a shuffled order. The build_destroy rows fill a
+ * container from empty and tear it down again, so their per-key op includes
+ * its share of tdestroy or hdestroy_r, which differ between libcs. Tree and hash lookups report
+ * the container's resident memory per key (bytes_per_key metric) from 1e5
+ * keys up, where the delta dominates allocator noise.
+ *
+ * hsearch only takes string keys, and lsearch/lfind are quadratic to build,
+ * so they stop at 1e4 keys.
+ */
+
+typedef struct
+{
+    size_t n;
+    int str;
+    int *ints;
+    char **strs;
+    char *arena;
+    void **tkey;   /* tsearch keys: &ints[i] or strs[i] */
+    size_t *order; /* shuffled indices for lookups and deletes */
+    size_t cursor;
+    void *root;
+    struct hsearch_data htab;
+    int has_htab;
+    void *list; /* lsearch array, n elements of ints or strs */
+} search_state;
+
+enum
+{
+    BUILD_NONE,
+    BUILD_TREE,
+    BUILD_HASH,
+};
+
+static int cmp_int(const void *a, const void *b)
+{
+    int ia = *(const int *)a, ib = *(const int *)b;
+    return (ia > ib) - (ia < ib);
+}
+static int cmp_str(const void *a, const void *b)
+{
+    return strcmp((const char *)a, (const char *)b);
+}
+/* lsearch/lfind compare array elements, i.e. char ** for string keys */
+static int cmp_str_elem(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void free_node(void *node)
+{
+    (void)node;
+}
+
+static void search_init(void **state, size_t n, int str, int build)
+{
+    search_state *st = xmalloc(sizeof(*st));
+    memset(st, 0, sizeof(*st));
+    st->n = n;
+    st->str = str;
+    st->tkey = xmalloc(n * sizeof(void *));
+    st->order = xmalloc(n * sizeof(size_t));
+    if (str)
+    {
+        /* Up to 16 hex digits, ':' and the index keep the keys distinct */
+        st->strs = xmalloc(n * sizeof(char *));
+        st->arena = xmalloc(n * 28);
+        char *p = st->arena;
+        for (size_t i = 0; i < n; i++)
+        {
+            unsigned shift = (unsigned)(bench_rand() % 40);
+            int len = sprintf(p, "%llx:%zu", (unsigned long long)(bench_rand() >> shift), i);
+            st->strs[i] = p;
+            st->tkey[i] = p;
+            p += len + 1;
+        }
+        st->list = st->strs;
+    }
+    else
+    {
+        /* Multiplying by an odd constant is a bijection, so keys are distinct */
+        st->ints = xmalloc(n * sizeof(int));
+        for (size_t i = 0; i < n; i++)
+        {
+            st->ints[i] = (int)((unsigned)i * 2654435761u);
+            st->tkey[i] = &st->ints[i];
+        }
+        st->list = st->ints;
+    }
+    for (size_t i = 0; i < n; i++)
+        st->order[i] = i;
+    for (size_t i = n - 1; i > 0; i--)
+    {
+        size_t j = bench_rand_range(0, i);
+        size_t t = st->order[i];
+        st->order[i] = st->order[j];
+        st->order[j] = t;
+    }
+
+#ifdef __GLIBC__
+    /* glibc keeps freed pages resident and would hand them back uncounted;
+       musl returns them to the kernel itself */
+    malloc_trim(0);
+#endif
+    size_t rss = bench_rss_bytes();
+    if (build == BUILD_TREE)
+    {
+        for (size_t i = 0; i < n; i++)
+            tsearch(st->tkey[i], &st->root, str ? cmp_str : cmp_int);
+    }
+    else if (build == BUILD_HASH)
+    {
+        if (!hcreate_r(2 * n, &st->htab))
+            bench_out_of_memory();
+        st->has_htab = 1;
+        for (size_t i = 0; i < n; i++)
+        {
+            ENTRY e = {st->strs[i], NULL}, *r;
+            hsearch_r(e, ENTER, &r, &st->htab);
+        }
+    }
+    if (build != BUILD_NONE && n >= 100000)
+        bench_metric("bytes_per_key", (double)(bench_rss_bytes() - rss) / (double)n);
+    *state = st;
+}
+
+static void cleanup_search(void *state)
+{
+    search_state *st = (search_state *)state;
+    if (st->root)
+        tdestroy(st->root, free_node);
+    if (st->has_htab)
+        hdestroy_r(&st->htab);
+    free(st->ints);
+    free(st->strs);
+    free(st->arena);
+    free(st->tkey);
+    free(st->order);
+    free(st);
+}
+
+/* Next key index in shuffled order */
+static inline size_t search_next(search_state *st)
+{
+    size_t k = st->order[st->cursor];
+    if (++st->cursor == st->n)
+        st->cursor = 0;
+    return k;
+}
+
+/* tsearch: build a tree of all n keys from empty, then tdestroy it */
+static size_t run_tsearch_build_destroy(void *state, size_t iters)
+{
+    search_state *st = (search_state *)state;
+    int (*cmp)(const void *, const void *) = st->str ? cmp_str : cmp_int;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        void *root = NULL;
+        for (size_t k = 0; k < st->n; k++)
+        {
+            BENCH_DO_NOT_OPTIMIZE(tsearch(st->tkey[k], &root, cmp));
+            ops++;
+        }
+        tdestroy(root, free_node);
+    }
+    return ops;
+}
+
+static size_t run_tfind(void *state, size_t iters)
+{
+    search_state *st = (search_state *)state;
+    int (*cmp)(const void *, const void *) = st->str ? cmp_str : cmp_int;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        void *r = tfind(st->tkey[search_next(st)], &st->root, cmp);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+
+/* tdelete at a steady size: each operation deletes a key and reinserts it */
+static size_t run_tdelete(void *state, size_t iters)
+{
+    search_state *st = (search_state *)state;
+    int (*cmp)(const void *, const void *) = st->str ? cmp_str : cmp_int;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        void *key = st->tkey[search_next(st)];
+        BENCH_DO_NOT_OPTIMIZE(tdelete(key, &st->root, cmp));
+        BENCH_DO_NOT_OPTIMIZE(tsearch(key, &st->root, cmp));
+        ops++;
+    }
+    return ops;
+}
+
+/* hsearch_r: fill a table sized for load factor 0.5 from empty, then destroy it */
+static size_t run_hsearch_build_destroy(void *state, size_t iters)
+{
+    search_state *st = (search_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        struct hsearch_data htab;
+        memset(&htab, 0, sizeof(htab));
+        if (!hcreate_r(2 * st->n, &htab))
+            bench_out_of_memory();
+        for (size_t k = 0; k < st->n; k++)
+        {
+            ENTRY e = {st->strs[k], NULL}, *r;
+            hsearch_r(e, ENTER, &r, &htab);
+            BENCH_DO_NOT_OPTIMIZE(r);
+            ops++;
+        }
+        hdestroy_r(&htab);
+    }
+    return ops;
+}
+
+static size_t run_hsearch_find(void *state, size_t iters)
+{
+    search_state *st = (search_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        ENTRY e = {st->strs[search_next(st)], NULL}, *r;
+        hsearch_r(e, FIND, &r, &st->htab);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+
+/* lsearch: append all n keys to an empty array (each scans what is there) */
+static size_t run_lsearch_insert(void *state, size_t iters)
+{
+    search_state *st = (search_state *)state;
+    size_t size = st->str ? sizeof(char *) : sizeof(int);
+    int (*cmp)(const void *, const void *) = st->str ? cmp_str_elem : cmp_int;
+    unsigned char *arr = xmalloc(st->n * size);
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t nel = 0;
+        for (size_t k = 0; k < st->n; k++)
+        {
+            BENCH_DO_NOT_OPTIMIZE(lsearch((unsigned char *)st->list + k * size, arr, &nel, size, cmp));
+            ops++;
+        }
+    }
+    free(arr);
+    return ops;
+}
+
+static size_t run_lfind(void *state, size_t iters)
+{
+    search_state *st = (search_state *)state;
+    size_t size = st->str ? sizeof(char *) : sizeof(int);
+    int (*cmp)(const void *, const void *) = st->str ? cmp_str_elem : cmp_int;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        const void *key = (unsigned char *)st->list + search_next(st) * size;
+        void *r = lfind(key, st->list, &st->n, size, cmp);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+
+/* Init wrappers: key type and count per benchmark */
+#define SEARCH_INITS(tag, n)                                                                 \
+    static void init_keys_int_##tag(void **state) { search_init(state, n, 0, BUILD_NONE); } \
+    static void init_keys_str_##tag(void **state) { search_init(state, n, 1, BUILD_NONE); } \
+    static void init_tree_int_##tag(void **state) { search_init(state, n, 0, BUILD_TREE); } \
+    static void init_tree_str_##tag(void **state) { search_init(state, n, 1, BUILD_TREE); } \
+    static void init_hash_str_##tag(void **state) { search_init(state, n, 1, BUILD_HASH); }
+SEARCH_INITS(1k, 1000)
+SEARCH_INITS(10k, 10000)
+SEARCH_INITS(100k, 100000)
+SEARCH_INITS(1m, 1000000)
+
+#define SEARCH_ENTRIES(tag)                                                                                  \
+    {"tsearch_build_destroy_int_" #tag, init_keys_int_##tag, run_tsearch_build_destroy, cleanup_search},     \
+        {"tsearch_build_destroy_str_" #tag, init_keys_str_##tag, run_tsearch_build_destroy, cleanup_search}, \
+        {"tfind_int_" #tag, init_tree_int_##tag, run_tfind, cleanup_search},                                 \
+        {"tfind_str_" #tag, init_tree_str_##tag, run_tfind, cleanup_search},                                 \
+        {"tdelete_int_" #tag, init_tree_int_##tag, run_tdelete, cleanup_search},                             \
+        {"tdelete_str_" #tag, init_tree_str_##tag, run_tdelete, cleanup_search},                             \
+        {"hsearch_build_destroy_str_" #tag, init_keys_str_##tag, run_hsearch_build_destroy, cleanup_search}, \
+        {"hsearch_find_str_" #tag, init_hash_str_##tag, run_hsearch_find, cleanup_search}
+#define LSEARCH_ENTRIES(tag)                                                                                 \
+    {"lsearch_insert_int_" #tag, init_keys_int_##tag, run_lsearch_insert, cleanup_search},                   \
+        {"lsearch_insert_str_" #tag, init_keys_str_##tag, run_lsearch_insert, cleanup_search},               \
+        {"lfind_int_" #tag, init_keys_int_##tag, run_lfind, cleanup_search},                                 \
+        {"lfind_str_" #tag, init_keys_str_##tag, run_lfind, cleanup_search}
+
+static const Benchmark search_benchmarks[] = {
+    SEARCH_ENTRIES(1k),
+    SEARCH_ENTRIES(10k),
+    SEARCH_ENTRIES(100k),
+    SEARCH_ENTRIES(1m),
+    LSEARCH_ENTRIES(1k),
+    LSEARCH_ENTRIES(10k),
+};
+BENCH_REGISTER_TABLE(search_benchmarks)
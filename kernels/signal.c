@@ -0,0 +1,335 @@
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <setjmp.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libcbench.h"
+
+#ifdef __GLIBC__
+#include <ucontext.h>
+#endif
+
+/*
+ * Non-local jumps, signal masks and signal delivery, the primitives under
+ * coroutine runtimes and crash handlers. One op is one round trip:
+ *
+ *   setjmp_longjmp          setjmp, then longjmp back from a called function
+ *   sigsetjmp_nomask        the same with sigsetjmp(env, 0)
+ *   sigsetjmp_mask          sigsetjmp(env, 1): saves and restores the signal
+ *                           mask, a system call each way in glibc
+ *   sigprocmask_block       block SIGUSR2, then restore the old mask
+ *   pthread_sigmask_block   the same through pthread_sigmask
+ *   pthread_sigmask_query   read the mask without changing it
+ *   raise_handler           raise(SIGUSR1) into an installed handler
+ *   swapcontext_roundtrip   swap into a makecontext coroutine and back
+ *   getcontext              capture the current context
+ *
+ * musl has no ucontext functions, so the last two rows are glibc only.
+ * sigprocmask and the handler are process-wide, so those rows do not run in
+ * concurrent mode.
+ */
+
+typedef struct
+{
+    jmp_buf env;
+    sigjmp_buf senv;
+    sigset_t set;
+} jump_state;
+
+static void init_jump(void **state)
+{
+    jump_state *st = xmalloc(sizeof(*st));
+    sigemptyset(&st->set);
+    sigaddset(&st->set, SIGUSR2);
+    *state = st;
+}
+
+static void cleanup_free(void *state)
+{
+    free(state);
+}
+
+/* Out of line, so every longjmp unwinds a real frame */
+__attribute__((noinline)) static void jump_back(jump_state *st)
+{
+    longjmp(st->env, 1);
+}
+
+__attribute__((noinline)) static void sigjump_back(jump_state *st)
+{
+    siglongjmp(st->senv, 1);
+}
+
+/* One setjmp and the longjmp back to it; the loops stay outside the jump */
+__attribute__((noinline)) static void jump_roundtrip(jump_state *st)
+{
+    if (!setjmp(st->env))
+        jump_back(st);
+}
+
+/* sigsetjmp is a macro in glibc, so savemask is a literal in each copy */
+__attribute__((noinline)) static void sigjump_nomask(jump_state *st)
+{
+    if (!sigsetjmp(st->senv, 0))
+        sigjump_back(st);
+}
+
+__attribute__((noinline)) static void sigjump_mask(jump_state *st)
+{
+    if (!sigsetjmp(st->senv, 1))
+        sigjump_back(st);
+}
+
+#define JUMP_KERNELS(name, roundtrip)                                           \
+    static size_t run_##name(void *state, size_t iters)                         \
+    {                                                                           \
+        for (size_t i = 0; i < iters; i++)                                      \
+        {                                                                       \
+            roundtrip((jump_state *)state);                                     \
+            BENCH_CLOBBER_MEMORY();                                             \
+        }                                                                       \
+        return iters;                                                           \
+    }                                                                           \
+    static size_t lat_##name(void *state, size_t iters, bench_hist *h)          \
+    {                                                                           \
+        for (size_t i = 0; i < iters; i++)                                      \
+        {                                                                       \
+            uint64_t t0 = bench_tsc_begin();                                    \
+            roundtrip((jump_state *)state);                                     \
+            BENCH_CLOBBER_MEMORY();                                             \
+            bench_hist_record(h, bench_tsc_end() - t0);                         \
+        }                                                                       \
+        return iters;                                                           \
+    }
+JUMP_KERNELS(setjmp, jump_roundtrip)
+JUMP_KERNELS(sigsetjmp_nomask, sigjump_nomask)
+JUMP_KERNELS(sigsetjmp_mask, sigjump_mask)
+
+/* Returns both calls' results combined, for the loops' barrier */
+static int mask_block(jump_state *st, int thread)
+{
+    sigset_t old;
+    int r;
+    if (thread)
+    {
+        r = pthread_sigmask(SIG_BLOCK, &st->set, &old);
+        r |= pthread_sigmask(SIG_SETMASK, &old, NULL);
+    }
+    else
+    {
+        r = sigprocmask(SIG_BLOCK, &st->set, &old);
+        r |= sigprocmask(SIG_SETMASK, &old, NULL);
+    }
+    return r;
+}
+
+static size_t run_sigprocmask(void *state, size_t iters)
+{
+    for (size_t i = 0; i < iters; i++)
+        BENCH_DO_NOT_OPTIMIZE(mask_block((jump_state *)state, 0));
+    return iters;
+}
+
+static size_t lat_sigprocmask(void *state, size_t iters, bench_hist *h)
+{
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        BENCH_DO_NOT_OPTIMIZE(mask_block((jump_state *)state, 0));
+        bench_hist_record(h, bench_tsc_end() - t0);
+    }
+    return iters;
+}
+
+static size_t run_pthread_sigmask(void *state, size_t iters)
+{
+    for (size_t i = 0; i < iters; i++)
+        BENCH_DO_NOT_OPTIMIZE(mask_block((jump_state *)state, 1));
+    return iters;
+}
+
+static size_t lat_pthread_sigmask(void *state, size_t iters, bench_hist *h)
+{
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        BENCH_DO_NOT_OPTIMIZE(mask_block((jump_state *)state, 1));
+        bench_hist_record(h, bench_tsc_end() - t0);
+    }
+    return iters;
+}
+
+static size_t run_sigmask_query(void *state, size_t iters)
+{
+    (void)state;
+    for (size_t i = 0; i < iters; i++)
+    {
+        sigset_t cur;
+        pthread_sigmask(SIG_BLOCK, NULL, &cur);
+        BENCH_DO_NOT_OPTIMIZE(cur);
+    }
+    return iters;
+}
+
+static volatile sig_atomic_t delivered;
+static struct sigaction saved_action;
+
+static void on_usr1(int sig)
+{
+    (void)sig;
+    delivered++;
+}
+
+static void init_raise(void **state)
+{
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_usr1;
+    sigemptyset(&sa.sa_mask);
+    /* The state is non-NULL only once the handler is installed */
+    *state = NULL;
+    if (sigaction(SIGUSR1, &sa, &saved_action) != 0)
+    {
+        bench_skip("sigaction failed");
+        return;
+    }
+    *state = &saved_action;
+}
+
+static void cleanup_raise(void *state)
+{
+    if (state)
+        sigaction(SIGUSR1, &saved_action, NULL);
+}
+
+/* raise returns after the handler has run, so each op is a full delivery */
+static size_t run_raise(void *state, size_t iters)
+{
+    (void)state;
+    for (size_t i = 0; i < iters; i++)
+        BENCH_DO_NOT_OPTIMIZE(raise(SIGUSR1));
+    return iters;
+}
+
+static size_t lat_raise(void *state, size_t iters, bench_hist *h)
+{
+    (void)state;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        BENCH_DO_NOT_OPTIMIZE(raise(SIGUSR1));
+        bench_hist_record(h, bench_tsc_end() - t0);
+    }
+    return iters;
+}
+
+#ifdef __GLIBC__
+#define CO_STACK ((size_t)64 << 10)
+
+typedef struct
+{
+    ucontext_t main;
+    ucontext_t co;
+    ucontext_t tmp;
+    void *stack;
+} context_state;
+
+/* makecontext only passes ints, so the state pointer arrives in two halves */
+static void co_entry(unsigned hi, unsigned lo)
+{
+    context_state *st = (context_state *)(((uintptr_t)hi << 32) | lo);
+    for (;;)
+        swapcontext(&st->co, &st->main);
+}
+
+static void init_context(void **state)
+{
+    context_state *st = xmalloc(sizeof(*st));
+    st->stack = xmalloc(CO_STACK);
+    *state = st;
+    if (getcontext(&st->co) != 0)
+    {
+        bench_skip("getcontext failed");
+        return;
+    }
+    st->co.uc_stack.ss_sp = st->stack;
+    st->co.uc_stack.ss_size = CO_STACK;
+    st->co.uc_link = NULL;
+    uintptr_t p = (uintptr_t)st;
+    makecontext(&st->co, (void (*)(void))co_entry, 2, (unsigned)((uint64_t)p >> 32), (unsigned)p);
+}
+
+static void cleanup_context(void *state)
+{
+    context_state *st = (context_state *)state;
+    free(st->stack);
+    free(st);
+}
+
+static size_t run_swapcontext(void *state, size_t iters)
+{
+    context_state *st = (context_state *)state;
+    for (size_t i = 0; i < iters; i++)
+        swapcontext(&st->main, &st->co);
+    return iters;
+}
+
+static size_t lat_swapcontext(void *state, size_t iters, bench_hist *h)
+{
+    context_state *st = (context_state *)state;
+    for (size_t i = 0; i < iters; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        swapcontext(&st->main, &st->co);
+        bench_hist_record(h, bench_tsc_end() - t0);
+    }
+    return iters;
+}
+
+static size_t run_getcontext(void *state, size_t iters)
+{
+    context_state *st = (context_state *)state;
+    for (size_t i = 0; i < iters; i++)
+    {
+        getcontext(&st->tmp);
+        BENCH_CLOBBER_MEMORY();
+    }
+    return iters;
+}
+#else
+static void init_context(void **state)
+{
+    *state = NULL;
+    bench_skip("no ucontext functions in this libc");
+}
+
+static void cleanup_context(void *state)
+{
+    (void)state;
+}
+
+static size_t run_swapcontext(void *state, size_t iters)
+{
+    (void)state;
+    return iters;
+}
+
+#define lat_swapcontext NULL
+#define run_getcontext run_swapcontext
+#endif
+
+static const Benchmark signal_benchmarks[] = {
+    {"setjmp_longjmp", init_jump, run_setjmp, cleanup_free, 0, lat_setjmp},
+    {"sigsetjmp_nomask", init_jump, run_sigsetjmp_nomask, cleanup_free, 0, lat_sigsetjmp_nomask},
+    {"sigsetjmp_mask", init_jump, run_sigsetjmp_mask, cleanup_free, 0, lat_sigsetjmp_mask},
+    {"sigprocmask_block", init_jump, run_sigprocmask, cleanup_free, BENCH_F_NOT_MT, lat_sigprocmask},
+    {"pthread_sigmask_block", init_jump, run_pthread_sigmask, cleanup_free, 0, lat_pthread_sigmask},
+    {"pthread_sigmask_query", init_jump, run_sigmask_query, cleanup_free},
+    {"raise_handler", init_raise, run_raise, cleanup_raise, BENCH_F_NOT_MT, lat_raise},
+    {"swapcontext_roundtrip", init_context, run_swapcontext, cleanup_context, 0, lat_swapcontext},
+    {"getcontext", init_context, run_getcontext, cleanup_context},
+};
+BENCH_REGISTER_TABLE(signal_benchmarks)
@@ -0,0 +1,287 @@
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libcbench.h"
+
+/*
+ * How much of a qsort result is the algorithm and how much the comparator
+ * call. All rows sort the same n random ints (4 Ki and 256 Ki):
+ *
+ *   sort_qsort_*         libc qsort, comparator through a function pointer
+ *   sort_qsort_r_*       libc qsort_r with a context argument
+ *   sort_introsort_cb_*  the introsort below, same comparator, same pointer
+ *   sort_introsort_*     the same introsort with the comparison inlined
+ *   sort_radix_*         LSD radix sort, 4 passes of 8 bits
+ *
+ * qsort against introsort_cb is the libc's algorithm; introsort_cb against
+ * introsort is the callback. qsort_r is a weak reference, since musl only
+ * has it from 1.2.3; without it the row is skipped.
+ */
+
+void qsort_r(void *base, size_t n, size_t size, int (*cmp)(const void *, const void *, void *), void *arg)
+    __attribute__((weak));
+
+typedef struct
+{
+    int (*cmp)(const void *, const void *);
+} sort_ctx;
+
+static int cmp_int(const void *a, const void *b)
+{
+    int ia = *(const int *)a, ib = *(const int *)b;
+    return (ia > ib) - (ia < ib);
+}
+
+static int cmp_int_r(const void *a, const void *b, void *arg)
+{
+    (void)arg;
+    int ia = *(const int *)a, ib = *(const int *)b;
+    return (ia > ib) - (ia < ib);
+}
+
+#define INSERTION_MAX 16
+
+/*
+ * Introsort over int: median-of-three quicksort that falls back to heapsort
+ * past 2*log2(n) levels and leaves runs of INSERTION_MAX or fewer for a
+ * final insertion sort. LESS(x, y) may use ctx.
+ */
+#define INTROSORT_DEFINE(NAME, LESS)                                                         \
+    static void NAME##_sift(int *a, size_t root, size_t n, const sort_ctx *ctx)              \
+    {                                                                                        \
+        (void)ctx;                                                                           \
+        int v = a[root];                                                                     \
+        for (size_t child; (child = 2 * root + 1) < n; root = child)                         \
+        {                                                                                    \
+            if (child + 1 < n && LESS(a[child], a[child + 1]))                               \
+                child++;                                                                     \
+            if (!LESS(v, a[child]))                                                          \
+                break;                                                                       \
+            a[root] = a[child];                                                              \
+        }                                                                                    \
+        a[root] = v;                                                                         \
+    }                                                                                        \
+    static void NAME##_heapsort(int *a, size_t n, const sort_ctx *ctx)                       \
+    {                                                                                        \
+        for (size_t i = n / 2; i-- > 0;)                                                     \
+            NAME##_sift(a, i, n, ctx);                                                       \
+        for (size_t end = n; end-- > 1;)                                                     \
+        {                                                                                    \
+            int t = a[0];                                                                    \
+            a[0] = a[end];                                                                   \
+            a[end] = t;                                                                      \
+            NAME##_sift(a, 0, end, ctx);                                                     \
+        }                                                                                    \
+    }                                                                                        \
+    static void NAME##_loop(int *a, size_t n, unsigned depth, const sort_ctx *ctx)           \
+    {                                                                                        \
+        (void)ctx;                                                                           \
+        while (n > INSERTION_MAX)                                                            \
+        {                                                                                    \
+            if (depth-- == 0)                                                                \
+            {                                                                                \
+                NAME##_heapsort(a, n, ctx);                                                  \
+                return;                                                                      \
+            }                                                                                \
+            /* Order first, middle and last so they bound both scans */                     \
+            size_t mid = n / 2, last = n - 1;                                                \
+            int t;                                                                           \
+            if (LESS(a[mid], a[0]))                                                          \
+                t = a[mid], a[mid] = a[0], a[0] = t;                                         \
+            if (LESS(a[last], a[mid]))                                                       \
+            {                                                                                \
+                t = a[last], a[last] = a[mid], a[mid] = t;                                   \
+                if (LESS(a[mid], a[0]))                                                      \
+                    t = a[mid], a[mid] = a[0], a[0] = t;                                     \
+            }                                                                                \
+            int p = a[mid];                                                                  \
+            size_t i = 0, j = last;                                                          \
+            for (;;)                                                                         \
+            {                                                                                \
+                do                                                                           \
+                    i++;                                                                     \
+                while (LESS(a[i], p));                                                       \
+                do                                                                           \
+                    j--;                                                                     \
+                while (LESS(p, a[j]));                                                       \
+                if (i >= j)                                                                  \
+                    break;                                                                   \
+                t = a[i], a[i] = a[j], a[j] = t;                                             \
+            }                                                                                \
+            /* [0, i) <= p <= [i, n); recurse into the smaller side */                       \
+            if (i < n - i)                                                                   \
+            {                                                                                \
+                NAME##_loop(a, i, depth, ctx);                                               \
+                a += i;                                                                      \
+                n -= i;                                                                      \
+            }                                                                                \
+            else                                                                             \
+            {                                                                                \
+                NAME##_loop(a + i, n - i, depth, ctx);                                       \
+                n = i;                                                                       \
+            }                                                                                \
+        }                                                                                    \
+    }                                                                                        \
+    static void NAME(int *a, size_t n, const sort_ctx *ctx)                                  \
+    {                                                                                        \
+        unsigned depth = 0;                                                                  \
+        for (size_t k = n; k > 1; k >>= 1)                                                   \
+            depth += 2;                                                                      \
+        NAME##_loop(a, n, depth, ctx);                                                       \
+        for (size_t i = 1; i < n; i++)                                                       \
+        {                                                                                    \
+            int v = a[i];                                                                    \
+            size_t j = i;                                                                    \
+            for (; j > 0 && LESS(v, a[j - 1]); j--)                                          \
+                a[j] = a[j - 1];                                                             \
+            a[j] = v;                                                                        \
+        }                                                                                    \
+    }
+
+#define LESS_INLINE(x, y) ((x) < (y))
+#define LESS_CALLBACK(x, y) (ctx->cmp(&(x), &(y)) < 0)
+INTROSORT_DEFINE(introsort_int, LESS_INLINE)
+INTROSORT_DEFINE(introsort_cb, LESS_CALLBACK)
+
+/* Signed keys are flipped to unsigned order; passes where every key falls in
+   one bucket are skipped. */
+static void radix_sort_int(int *a, int *tmp, size_t n)
+{
+    size_t count[4][256] = {{0}};
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t k = (uint32_t)a[i] ^ 0x80000000u;
+        for (int d = 0; d < 4; d++)
+            count[d][(k >> (8 * d)) & 0xff]++;
+    }
+    int *src = a, *dst = tmp;
+    for (int d = 0; d < 4; d++)
+    {
+        size_t sum = 0, pos[256];
+        int trivial = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            if (count[d][b] == n)
+                trivial = 1;
+            pos[b] = sum;
+            sum += count[d][b];
+        }
+        if (trivial)
+            continue;
+        for (size_t i = 0; i < n; i++)
+        {
+            uint32_t k = (uint32_t)src[i] ^ 0x80000000u;
+            dst[pos[(k >> (8 * d)) & 0xff]++] = src[i];
+        }
+        int *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != a)
+        memcpy(a, src, n * sizeof(int));
+}
+
+enum
+{
+    SORT_QSORT,
+    SORT_QSORT_R,
+    SORT_INTRO_CB,
+    SORT_INTRO,
+    SORT_RADIX,
+};
+
+typedef struct
+{
+    int *orig;
+    int *work;
+    int *tmp;
+    size_t n;
+    int algo;
+    sort_ctx ctx;
+} sort_state;
+
+static void init_sort(void **state, size_t n, int algo)
+{
+    sort_state *st = xmalloc(sizeof(*st));
+    st->n = n;
+    st->algo = algo;
+    st->ctx.cmp = cmp_int;
+    st->orig = xmalloc(n * sizeof(int));
+    st->work = xmalloc(n * sizeof(int));
+    st->tmp = xmalloc(n * sizeof(int));
+    /* Fixed seed rather than bench_rand, whose stream depends on the row
+       name: every algorithm gets the same array */
+    uint64_t x = 0x2545f4914f6cdd1dull;
+    for (size_t i = 0; i < n; i++)
+    {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        st->orig[i] = (int)(uint32_t)(x >> 32);
+    }
+    *state = st;
+    if (algo == SORT_QSORT_R && !qsort_r)
+        bench_skip("qsort_r not available in this libc");
+}
+
+static void cleanup_sort(void *state)
+{
+    sort_state *st = (sort_state *)state;
+    free(st->orig);
+    free(st->work);
+    free(st->tmp);
+    free(st);
+}
+
+static size_t run_sort(void *state, size_t iters)
+{
+    sort_state *st = (sort_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        memcpy(st->work, st->orig, st->n * sizeof(int));
+        switch (st->algo)
+        {
+        case SORT_QSORT:
+            qsort(st->work, st->n, sizeof(int), st->ctx.cmp);
+            break;
+        case SORT_QSORT_R:
+            qsort_r(st->work, st->n, sizeof(int), cmp_int_r, &st->ctx);
+            break;
+        case SORT_INTRO_CB:
+            introsort_cb(st->work, st->n, &st->ctx);
+            break;
+        case SORT_INTRO:
+            introsort_int(st->work, st->n, &st->ctx);
+            break;
+        default:
+            radix_sort_int(st->work, st->tmp, st->n);
+            break;
+        }
+        BENCH_DO_NOT_OPTIMIZE(st->work[st->n / 2]);
+        ops++;
+    }
+    return ops;
+}
+
+#define SORT_INITS(tag, n)                                                                     \
+    static void init_qsort_##tag(void **state) { init_sort(state, n, SORT_QSORT); }         \
+    static void init_qsort_r_##tag(void **state) { init_sort(state, n, SORT_QSORT_R); }     \
+    static void init_intro_cb_##tag(void **state) { init_sort(state, n, SORT_INTRO_CB); }   \
+    static void init_intro_##tag(void **state) { init_sort(state, n, SORT_INTRO); }         \
+    static void init_radix_##tag(void **state) { init_sort(state, n, SORT_RADIX); }
+SORT_INITS(4k, 4096)
+SORT_INITS(256k, 262144)
+
+#define SORT_ENTRIES(tag)                                                           \
+    {"sort_qsort_" #tag, init_qsort_##tag, run_sort, cleanup_sort},               \
+        {"sort_qsort_r_" #tag, init_qsort_r_##tag, run_sort, cleanup_sort},       \
+        {"sort_introsort_cb_" #tag, init_intro_cb_##tag, run_sort, cleanup_sort}, \
+        {"sort_introsort_" #tag, init_intro_##tag, run_sort, cleanup_sort},       \
+        {"sort_radix_" #tag, init_radix_##tag, run_sort, cleanup_sort}
+
+static const Benchmark sort_benchmarks[] = {
+    SORT_ENTRIES(4k),
+    SORT_ENTRIES(256k),
+};
+BENCH_REGISTER_TABLE(sort_benchmarks)
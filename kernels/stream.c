@@ -0,0 +1,282 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "../libcbench.h"
+
+/*
+ * Line splitting over a log corpus far larger than any cache, generated once
+ * per process as a temporary file of -S MiB in $TMPDIR (/var/tmp when unset,
+ * which is usually disk- rather than memory-backed) and removed at exit. One
+ * op is one full pass; each pass opens the file again:
+ *
+ *   stream_fgets         fgets into a 4 KiB buffer
+ *   stream_getline       getline
+ *   stream_getdelim      getdelim on '\n'
+ *   stream_fread_memchr  fread of 1 MiB blocks, memchr for each newline
+ *   stream_mmap_memchr   mmap of the whole file, memchr for each newline
+ *
+ * Rows report corpus_bytes and lines per pass, from which generate.py
+ * derives GB/s, and peak_rss_mib, the largest resident set seen at the end
+ * of a pass (the mapped file counts for mmap). RSS is per process, so the
+ * rows stay out of concurrent mode.
+ */
+
+#define LINE_MAX_LEN 4096
+#define BLOCK ((size_t)1 << 20)
+
+static char corpus_path[256];
+static int corpus_tried;
+static size_t corpus_len;
+static size_t corpus_lines;
+
+static void remove_corpus(void)
+{
+    if (corpus_path[0])
+        unlink(corpus_path);
+}
+
+static const char *const METHODS[] = {"GET", "GET", "GET", "POST", "PUT", "HEAD"};
+static const char *const AGENTS[] = {
+    "curl/8.5.0",
+    "Mozilla/5.0 (X11; Linux x86_64; rv:128.0) Gecko/20100101 Firefox/128.0",
+    "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/126.0 Safari/537.36",
+    "Prometheus/2.53.0",
+};
+
+/*
+ * Combined Log Format lines, 100 to 300 bytes. A fixed LCG rather than
+ * bench_rand, whose stream depends on the first row's name: every row and
+ * both libcs get the same bytes.
+ */
+static int generate_corpus(size_t target)
+{
+    const char *dir = getenv("TMPDIR");
+    snprintf(corpus_path, sizeof(corpus_path), "%s/libcbench-corpus-XXXXXX", dir && *dir ? dir : "/var/tmp");
+    int fd = mkstemp(corpus_path);
+    if (fd < 0)
+    {
+        corpus_path[0] = '\0';
+        return -1;
+    }
+    atexit(remove_corpus);
+
+    char *buf = xmalloc(BLOCK + LINE_MAX_LEN);
+    size_t fill = 0;
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    while (corpus_len < target)
+    {
+        x = x * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t r = (uint32_t)(x >> 32);
+        unsigned path_len = 8 + r % 64;
+        char path[80];
+        for (unsigned k = 0; k < path_len; k++)
+            path[k] = "abcdefghijklmnopqrstuvwxyz0123456789/-_"[(r >> (k % 24)) % 39];
+        path[path_len] = '\0';
+        int n = snprintf(buf + fill, LINE_MAX_LEN,
+                         "10.%u.%u.%u - - [%02u/Oct/2024:%02u:%02u:%02u +0000] \"%s /%s HTTP/1.1\" %u %u \"-\" \"%s\"\n",
+                         r & 0xff, (r >> 8) & 0xff, (r >> 16) & 0xff, 1 + r % 28, r % 24, (r >> 3) % 60,
+                         (r >> 9) % 60, METHODS[r % 6], path, (r & 0x10) ? 200u : 404u, r % 100000,
+                         AGENTS[(r >> 20) % 4]);
+        fill += (size_t)n;
+        corpus_len += (size_t)n;
+        corpus_lines++;
+        if (fill >= BLOCK || corpus_len >= target)
+        {
+            if (write(fd, buf, fill) != (ssize_t)fill)
+            {
+                corpus_len = 0;
+                free(buf);
+                close(fd);
+                return -1;
+            }
+            fill = 0;
+        }
+    }
+    free(buf);
+    close(fd);
+    return 0;
+}
+
+enum
+{
+    STREAM_FGETS,
+    STREAM_GETLINE,
+    STREAM_GETDELIM,
+    STREAM_FREAD,
+    STREAM_MMAP,
+};
+
+typedef struct
+{
+    int method;
+    size_t peak_rss;
+    char *block; /* fread buffer */
+} stream_state;
+
+static void init_stream(void **state, int method)
+{
+    stream_state *st = xmalloc(sizeof(*st));
+    st->method = method;
+    st->peak_rss = 0;
+    st->block = method == STREAM_FREAD ? xmalloc(BLOCK) : NULL;
+    *state = st;
+    if (!corpus_tried)
+    {
+        corpus_tried = 1;
+        fprintf(stderr, "generating %zu MiB corpus...\n", bench_corpus_bytes() >> 20);
+        if (generate_corpus(bench_corpus_bytes()) != 0)
+            fprintf(stderr, "note: could not write the corpus file\n");
+    }
+    if (!corpus_len)
+    {
+        bench_skip("no corpus file");
+        return;
+    }
+    bench_metric("corpus_bytes", (double)corpus_len);
+    bench_metric("lines", (double)corpus_lines);
+}
+
+static void cleanup_stream(void *state)
+{
+    stream_state *st = (stream_state *)state;
+    free(st->block);
+    free(st);
+}
+
+/* Called with the pass's buffers still live */
+static void note_rss(stream_state *st)
+{
+    size_t rss = bench_rss_bytes();
+    if (rss > st->peak_rss)
+    {
+        st->peak_rss = rss;
+        bench_metric("peak_rss_mib", (double)rss / (1 << 20));
+    }
+}
+
+static size_t stdio_pass(stream_state *st)
+{
+    FILE *f = fopen(corpus_path, "r");
+    if (!f)
+        abort();
+    size_t lines = 0;
+    if (st->method == STREAM_FGETS)
+    {
+        char buf[LINE_MAX_LEN];
+        while (fgets(buf, sizeof(buf), f))
+        {
+            BENCH_DO_NOT_OPTIMIZE(buf[0]);
+            lines++;
+        }
+        note_rss(st);
+    }
+    else
+    {
+        char *line = NULL;
+        size_t cap = 0;
+        while ((st->method == STREAM_GETLINE ? getline(&line, &cap, f) : getdelim(&line, &cap, '\n', f)) > 0)
+        {
+            BENCH_DO_NOT_OPTIMIZE(line[0]);
+            lines++;
+        }
+        note_rss(st);
+        free(line);
+    }
+    fclose(f);
+    return lines;
+}
+
+/* Lines crossing a block boundary are counted once, in the block holding
+   their newline */
+static size_t fread_pass(stream_state *st)
+{
+    FILE *f = fopen(corpus_path, "r");
+    if (!f)
+        abort();
+    size_t lines = 0, n;
+    while ((n = fread(st->block, 1, BLOCK, f)) > 0)
+    {
+        const char *p = st->block, *end = st->block + n, *nl;
+        while ((nl = memchr(p, '\n', (size_t)(end - p))) != NULL)
+        {
+            BENCH_DO_NOT_OPTIMIZE(*p);
+            lines++;
+            p = nl + 1;
+        }
+    }
+    note_rss(st);
+    fclose(f);
+    return lines;
+}
+
+static size_t mmap_pass(stream_state *st)
+{
+    int fd = open(corpus_path, O_RDONLY);
+    if (fd < 0)
+        abort();
+    const char *base = mmap(NULL, corpus_len, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED)
+        abort();
+    madvise((void *)base, corpus_len, MADV_SEQUENTIAL);
+    size_t lines = 0;
+    const char *p = base, *end = base + corpus_len, *nl;
+    while ((nl = memchr(p, '\n', (size_t)(end - p))) != NULL)
+    {
+        BENCH_DO_NOT_OPTIMIZE(*p);
+        lines++;
+        p = nl + 1;
+    }
+    note_rss(st);
+    munmap((void *)base, corpus_len);
+    close(fd);
+    return lines;
+}
+
+static size_t run_stream(void *state, size_t iters)
+{
+    stream_state *st = (stream_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        size_t lines;
+        switch (st->method)
+        {
+        case STREAM_FREAD:
+            lines = fread_pass(st);
+            break;
+        case STREAM_MMAP:
+            lines = mmap_pass(st);
+            break;
+        default:
+            lines = stdio_pass(st);
+            break;
+        }
+        if (lines != corpus_lines)
+            abort();
+        ops++;
+    }
+    return ops;
+}
+
+static void init_stream_fgets(void **state) { init_stream(state, STREAM_FGETS); }
+static void init_stream_getline(void **state) { init_stream(state, STREAM_GETLINE); }
+static void init_stream_getdelim(void **state) { init_stream(state, STREAM_GETDELIM); }
+static void init_stream_fread(void **state) { init_stream(state, STREAM_FREAD); }
+static void init_stream_mmap(void **state) { init_stream(state, STREAM_MMAP); }
+
+#define STREAM_FLAGS (BENCH_F_STREAM | BENCH_F_NOT_MT)
+
+static const Benchmark stream_benchmarks[] = {
+    {"stream_fgets", init_stream_fgets, run_stream, cleanup_stream, STREAM_FLAGS},
+    {"stream_getline", init_stream_getline, run_stream, cleanup_stream, STREAM_FLAGS},
+    {"stream_getdelim", init_stream_getdelim, run_stream, cleanup_stream, STREAM_FLAGS},
+    {"stream_fread_memchr", init_stream_fread, run_stream, cleanup_stream, STREAM_FLAGS},
+    {"stream_mmap_memchr", init_stream_mmap, run_stream, cleanup_stream, STREAM_FLAGS},
+};
+BENCH_REGISTER_TABLE(stream_benchmarks)
@@ -0,0 +1,319 @@
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+
+#include "../libcbench.h"
+
+/*
+ * Bounded and chaining string copies: explicit_bzero, strlcpy/strlcat,
+ * memccpy, stpcpy/stpncpy and strdup/strndup. Like strnlen/strncmp/strncpy
+ * in benchmark.c, consecutive calls sweep the length, here 8..SWEEP_MAX
+ * bytes: the source is the tail of a SWEEP_MAX-byte string, so shorter
+ * strings also start at varying alignments. The _trunc32 rows copy the
+ * same strings into a 32-byte buffer, where strlcpy still has to find the
+ * end of the source and memccpy stops early.
+ *
+ * The concat_* rows build one string from 16 or 64 pieces, one append per
+ * operation: strcat and strlcat rescan what was built so far (the strcat
+ * row's pattern), stpcpy continues from the returned end.
+ *
+ * strlcpy/strlcat are in glibc only since 2.38; older glibc skips them.
+ */
+
+#define SWEEP_MAX 1024
+#define DST_CAP (SWEEP_MAX + 64)
+
+#if !defined(__GLIBC__) || __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 38)
+#define HAVE_STRLCPY 1
+#else
+#define HAVE_STRLCPY 0
+#endif
+
+typedef struct
+{
+    bench_ring ring; /* each slot: SWEEP_MAX-byte src, then dst at SWEEP_MAX + 1 */
+} sweep_state;
+
+static void init_sweep(void **state)
+{
+    sweep_state *st = xmalloc(sizeof(*st));
+    size_t slot = SWEEP_MAX + 1 + DST_CAP;
+    char *tmpl = xmalloc(slot);
+    for (size_t i = 0; i < SWEEP_MAX; i++)
+        tmpl[i] = (char)('a' + bench_rand() % 26);
+    tmpl[SWEEP_MAX] = '\0';
+    memset(tmpl + SWEEP_MAX + 1, 0, DST_CAP);
+    bench_ring_init(&st->ring, tmpl, slot);
+    free(tmpl);
+    *state = st;
+}
+
+static void init_sweep_strlcpy(void **state)
+{
+    init_sweep(state);
+    if (!HAVE_STRLCPY)
+        bench_skip("strlcpy/strlcat need glibc 2.38");
+}
+
+static void cleanup_sweep(void *state)
+{
+    bench_ring_free(&((sweep_state *)state)->ring);
+    free(state);
+}
+
+/* Length of call `iter` in the sweep */
+static inline size_t sweep_len(size_t iter)
+{
+    return 8 + (iter * 13) % (SWEEP_MAX - 7);
+}
+
+static size_t run_explicit_bzero(void *state, size_t iters)
+{
+    sweep_state *st = (sweep_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        char *src = bench_ring_next(&st->ring);
+        explicit_bzero(src + SWEEP_MAX + 1, sweep_len(i));
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+/* memset on the same sizes, the baseline explicit_bzero must not fall behind */
+static size_t run_memset_sweep(void *state, size_t iters)
+{
+    sweep_state *st = (sweep_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        char *src = bench_ring_next(&st->ring);
+        memset(src + SWEEP_MAX + 1, 0, sweep_len(i));
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+static size_t run_strlcpy(void *state, size_t iters, size_t cap)
+{
+    sweep_state *st = (sweep_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        char *src = bench_ring_next(&st->ring);
+#if HAVE_STRLCPY
+        size_t r = strlcpy(src + SWEEP_MAX + 1, src + SWEEP_MAX - sweep_len(i), cap);
+        BENCH_DO_NOT_OPTIMIZE(r);
+#else
+        (void)src;
+        (void)cap;
+#endif
+        ops++;
+    }
+    return ops;
+}
+static size_t run_strlcpy_sweep(void *state, size_t iters) { return run_strlcpy(state, iters, DST_CAP); }
+static size_t run_strlcpy_trunc(void *state, size_t iters) { return run_strlcpy(state, iters, 32); }
+
+/* memccpy(dst, src, '\0', cap) as a bounded strcpy */
+static size_t run_memccpy(void *state, size_t iters, size_t cap)
+{
+    sweep_state *st = (sweep_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        char *src = bench_ring_next(&st->ring);
+        void *r = memccpy(src + SWEEP_MAX + 1, src + SWEEP_MAX - sweep_len(i), '\0', cap);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+static size_t run_memccpy_sweep(void *state, size_t iters) { return run_memccpy(state, iters, DST_CAP); }
+static size_t run_memccpy_trunc(void *state, size_t iters) { return run_memccpy(state, iters, 32); }
+
+static size_t run_stpcpy_sweep(void *state, size_t iters)
+{
+    sweep_state *st = (sweep_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        char *src = bench_ring_next(&st->ring);
+        char *r = stpcpy(src + SWEEP_MAX + 1, src + SWEEP_MAX - sweep_len(i));
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+
+/* The bound is 16 bytes past the string, so every call also pads */
+static size_t run_stpncpy_sweep(void *state, size_t iters)
+{
+    sweep_state *st = (sweep_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        char *src = bench_ring_next(&st->ring);
+        size_t n = sweep_len(i);
+        char *r = stpncpy(src + SWEEP_MAX + 1, src + SWEEP_MAX - n, n + 16);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        ops++;
+    }
+    return ops;
+}
+
+/* One op is the copy plus its free */
+static size_t run_strdup_sweep(void *state, size_t iters)
+{
+    sweep_state *st = (sweep_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        char *src = bench_ring_next(&st->ring);
+        char *r = strdup(src + SWEEP_MAX - sweep_len(i));
+        BENCH_DO_NOT_OPTIMIZE(r);
+        free(r);
+        ops++;
+    }
+    return ops;
+}
+
+/* strndup of the first half of each string, as when copying out a prefix */
+static size_t run_strndup_sweep(void *state, size_t iters)
+{
+    sweep_state *st = (sweep_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        char *src = bench_ring_next(&st->ring);
+        size_t n = sweep_len(i);
+        char *r = strndup(src + SWEEP_MAX - n, n / 2);
+        BENCH_DO_NOT_OPTIMIZE(r);
+        free(r);
+        ops++;
+    }
+    return ops;
+}
+
+/* Concatenation chains */
+#define CONCAT_PIECE "segment1234567890" /* as in the strcat row */
+#define CONCAT_CAP 2048                  /* fits 64 pieces */
+
+typedef struct
+{
+    bench_ring src; /* the piece */
+    bench_ring dst; /* the CONCAT_CAP-byte buffer */
+    size_t pieces;
+} concat_state;
+
+static void init_concat(void **state, size_t pieces)
+{
+    concat_state *st = xmalloc(sizeof(*st));
+    char buf[CONCAT_CAP] = {0};
+    bench_ring_init(&st->src, CONCAT_PIECE, sizeof(CONCAT_PIECE));
+    bench_ring_init(&st->dst, buf, sizeof(buf));
+    st->pieces = pieces;
+    *state = st;
+}
+static void init_concat_16(void **state) { init_concat(state, 16); }
+static void init_concat_64(void **state) { init_concat(state, 64); }
+static void init_concat_strlcat_16(void **state)
+{
+    init_concat(state, 16);
+    if (!HAVE_STRLCPY)
+        bench_skip("strlcpy/strlcat need glibc 2.38");
+}
+static void init_concat_strlcat_64(void **state)
+{
+    init_concat(state, 64);
+    if (!HAVE_STRLCPY)
+        bench_skip("strlcpy/strlcat need glibc 2.38");
+}
+
+static void cleanup_concat(void *state)
+{
+    concat_state *st = (concat_state *)state;
+    bench_ring_free(&st->src);
+    bench_ring_free(&st->dst);
+    free(st);
+}
+
+static size_t run_concat_strcat(void *state, size_t iters)
+{
+    concat_state *st = (concat_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        const char *piece = bench_ring_next(&st->src);
+        char *buf = bench_ring_next(&st->dst);
+        buf[0] = '\0';
+        for (size_t k = 0; k < st->pieces; k++)
+        {
+            BENCH_DO_NOT_OPTIMIZE(strcat(buf, piece));
+            ops++;
+        }
+    }
+    return ops;
+}
+
+static size_t run_concat_stpcpy(void *state, size_t iters)
+{
+    concat_state *st = (concat_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        const char *piece = bench_ring_next(&st->src);
+        char *p = bench_ring_next(&st->dst);
+        for (size_t k = 0; k < st->pieces; k++)
+        {
+            p = stpcpy(p, piece);
+            BENCH_DO_NOT_OPTIMIZE(p);
+            ops++;
+        }
+    }
+    return ops;
+}
+
+static size_t run_concat_strlcat(void *state, size_t iters)
+{
+    concat_state *st = (concat_state *)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        const char *piece = bench_ring_next(&st->src);
+        char *buf = bench_ring_next(&st->dst);
+        buf[0] = '\0';
+        for (size_t k = 0; k < st->pieces; k++)
+        {
+#if HAVE_STRLCPY
+            BENCH_DO_NOT_OPTIMIZE(strlcat(buf, piece, CONCAT_CAP));
+#else
+            (void)piece;
+#endif
+            ops++;
+        }
+    }
+    return ops;
+}
+
+static const Benchmark strsafe_benchmarks[] = {
+    {"explicit_bzero_sweep", init_sweep, run_explicit_bzero, cleanup_sweep, BENCH_F_CACHE, .bytes = 8},
+    {"memset_sweep", init_sweep, run_memset_sweep, cleanup_sweep, BENCH_F_CACHE, .bytes = 8},
+    {"strlcpy_sweep", init_sweep_strlcpy, run_strlcpy_sweep, cleanup_sweep, BENCH_F_CACHE, .bytes = 16},
+    {"strlcpy_trunc32", init_sweep_strlcpy, run_strlcpy_trunc, cleanup_sweep, BENCH_F_CACHE, .bytes = 16},
+    {"memccpy_sweep", init_sweep, run_memccpy_sweep, cleanup_sweep, BENCH_F_CACHE, .bytes = 16},
+    {"memccpy_trunc32", init_sweep, run_memccpy_trunc, cleanup_sweep, BENCH_F_CACHE, .bytes = 16},
+    {"stpcpy_sweep", init_sweep, run_stpcpy_sweep, cleanup_sweep, BENCH_F_CACHE, .bytes = 16},
+    {"stpncpy_sweep", init_sweep, run_stpncpy_sweep, cleanup_sweep, BENCH_F_CACHE, .bytes = 16},
+    {"strdup_sweep", init_sweep, run_strdup_sweep, cleanup_sweep, BENCH_F_CACHE, .bytes = 16},
+    {"strndup_sweep", init_sweep, run_strndup_sweep, cleanup_sweep, BENCH_F_CACHE, .bytes = 8},
+    {"concat_strcat_16", init_concat_16, run_concat_strcat, cleanup_concat, BENCH_F_CACHE, .bytes = 32},
+    {"concat_stpcpy_16", init_concat_16, run_concat_stpcpy, cleanup_concat, BENCH_F_CACHE, .bytes = 32},
+    {"concat_strlcat_16", init_concat_strlcat_16, run_concat_strlcat, cleanup_concat, BENCH_F_CACHE, .bytes = 32},
+    {"concat_strcat_64", init_concat_64, run_concat_strcat, cleanup_concat, BENCH_F_CACHE, .bytes = 32},
+    {"concat_stpcpy_64", init_concat_64, run_concat_stpcpy, cleanup_concat, BENCH_F_CACHE, .bytes = 32},
+    {"concat_strlcat_64", init_concat_strlcat_64, run_concat_strlcat, cleanup_concat, BENCH_F_CACHE, .bytes = 32},
+};
+BENCH_REGISTER_TABLE(strsafe_benchmarks)
@@ -0,0 +1,965 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <fnmatch.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/auxv.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#include "libcbench.h"
+
+/* Cold mode: rotate over this many times the last-level cache size. */
+#define COLD_LLC_MULTIPLE 4
+#define COLD_MAX_BYTES (1ull << 30)
+
+static int cold_mode;
+static size_t llc_bytes;
+
+/*
+ * Latency histogram, HDR style: values below 2^HIST_BITS get their own
+ * bucket, larger ones keep HIST_BITS significant bits, i.e. each power of
+ * two is split into 2^(HIST_BITS-1) linear buckets (<1.6% relative error).
+ */
+#define HIST_BITS 7
+#define HIST_HALF (1u << (HIST_BITS - 1))
+#define HIST_BUCKETS ((64 - HIST_BITS + 1) * HIST_HALF + (1u << HIST_BITS))
+
+struct bench_hist
+{
+    uint64_t count;
+    uint64_t max;
+    double sum;
+    uint64_t buckets[HIST_BUCKETS];
+};
+
+/*
+ * Plausibility limit for Benchmark.bytes: current cores move at most about
+ * 256 bytes per cycle through L1 (two 64-byte loads and two stores); the
+ * factor 2 covers clocks above the TSC rate. Faster rows mean the compiler
+ * removed the work.
+ */
+#define MAX_BYTES_PER_CYCLE 512.0
+
+/*
+ * Adaptive sampling. The -t budget is split into batches of about
+ * 1/BATCHES_PER_BUDGET of it (at least TIMER_MULTIPLE timer reads long), and
+ * batches are repeated until the relative standard error of ns/op reaches
+ * target_rse or the budget is spent, after at least -r batches. Each batch
+ * has the cost of one timer read and of its empty iterations subtracted.
+ */
+#define BATCHES_PER_BUDGET 64
+#define TIMER_MULTIPLE 1000
+static double target_rse = 0.005;
+static double timer_ns;    /* back-to-back now_ns() */
+static double loop_ns;     /* one empty run() iteration */
+
+/*
+ * Large-buffer placement (-H, -N): bench_alloc_large maps buffers with
+ * transparent huge pages (madvise) or hugetlbfs pages and binds them to one
+ * NUMA node. Rings use it too once either option is given.
+ */
+#define HUGE_PAGE ((size_t)2 << 20)
+#define MPOL_BIND_ 2 /* <numaif.h> is not part of either libc */
+enum
+{
+    HUGE_NONE,
+    HUGE_THP,
+    HUGE_TLB,
+};
+static int huge_mode;
+static int numa_node = -1;
+
+static int latency_mode;
+static int pool_mode;
+static size_t corpus_bytes; /* -S: streaming mode when non-zero */
+static size_t threads; /* -j: concurrent mode when non-zero */
+static uint64_t seed = 0x5eed;
+static uint64_t rand_state;
+
+/* Metrics reported by the benchmark being measured */
+#define MAX_METRICS 8
+static const char *metric_names[MAX_METRICS];
+static double metric_values[MAX_METRICS];
+static size_t metric_count;
+
+/* Set by bench_skip() during init */
+static const char *skip_reason;
+
+static const Benchmark **registry;
+static size_t registry_len;
+static size_t registry_cap;
+
+static void
+die(const char *msg)
+{
+    fprintf(stderr, "FATAL: %s\n", msg);
+    exit(1);
+}
+
+#if defined(_MSC_VER)
+__declspec(noinline)
+#elif defined(__GNUC__) || defined(__clang__)
+__attribute__((cold, noinline))
+#endif
+void bench_out_of_memory(void)
+{
+    die("out of memory");
+}
+
+void bench_register(const Benchmark *b)
+{
+    if (registry_len == registry_cap)
+    {
+        registry_cap = registry_cap ? registry_cap * 2 : 64;
+        const Benchmark **grown = realloc(registry, registry_cap * sizeof(*registry));
+        if unlikely (!grown)
+        {
+            bench_out_of_memory();
+        }
+        registry = grown;
+    }
+    registry[registry_len++] = b;
+}
+
+void bench_register_table(const Benchmark *table, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        bench_register(&table[i]);
+}
+
+/* Largest cache reported in sysfs, 32 MiB if unknown. */
+static size_t detect_llc(void)
+{
+    size_t best = 0;
+    for (int idx = 0; idx < 8; idx++)
+    {
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%d/size", idx);
+        FILE *f = fopen(path, "r");
+        if (!f)
+            break;
+        unsigned long long v = 0;
+        char unit = 0;
+        if (fscanf(f, "%llu%c", &v, &unit) >= 1)
+        {
+            if (unit == 'K')
+                v <<= 10;
+            else if (unit == 'M')
+                v <<= 20;
+            if (v > best)
+                best = (size_t)v;
+        }
+        fclose(f);
+    }
+    return best ? best : (size_t)32 << 20;
+}
+
+static size_t large_length(size_t len)
+{
+    size_t unit = huge_mode != HUGE_NONE ? HUGE_PAGE : (size_t)sysconf(_SC_PAGESIZE);
+    return (len + unit - 1) & ~(unit - 1);
+}
+
+/* Binds [p, p + len) to numa_node; notes once and carries on when it cannot */
+static void bind_node(void *p, size_t len)
+{
+    static int warned;
+    unsigned long mask[16] = {0};
+    if (numa_node < 0)
+        return;
+    int ok = (size_t)numa_node < sizeof(mask) * 8;
+    if (ok)
+    {
+        mask[numa_node / 64] = 1ul << (numa_node % 64);
+        ok = syscall(SYS_mbind, p, len, MPOL_BIND_, mask, sizeof(mask) * 8, 0) == 0;
+    }
+    if (!ok && !warned)
+    {
+        fprintf(stderr, "note: cannot bind to NUMA node %d, using the default policy\n", numa_node);
+        warned = 1;
+    }
+}
+
+void *bench_alloc_large(size_t len)
+{
+    static int warned;
+    size_t size = large_length(len);
+    void *p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    if (huge_mode == HUGE_TLB)
+    {
+        p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p == MAP_FAILED && !warned)
+        {
+            fprintf(stderr, "note: no hugetlbfs pages reserved (vm.nr_hugepages), using THP instead\n");
+            warned = 1;
+        }
+    }
+#endif
+    if (p == MAP_FAILED)
+    {
+        /* Over-map by one huge page so the buffer can start on a boundary */
+        size_t extra = huge_mode != HUGE_NONE ? HUGE_PAGE : 0;
+        unsigned char *raw = mmap(NULL, size + extra, PROT_READ | PROT_WRITE,
+                                  MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (raw == MAP_FAILED)
+            bench_out_of_memory();
+        unsigned char *aligned = raw;
+        if (extra)
+        {
+            aligned = (unsigned char *)(((uintptr_t)raw + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1));
+            if (aligned > raw)
+                munmap(raw, (size_t)(aligned - raw));
+            if (aligned + size < raw + size + extra)
+                munmap(aligned + size, (size_t)(raw + size + extra - (aligned + size)));
+#ifdef MADV_HUGEPAGE
+            madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+        }
+        p = aligned;
+    }
+    bind_node(p, size);
+    return p;
+}
+
+void bench_free_large(void *p, size_t len)
+{
+    if (p)
+        munmap(p, large_length(len));
+}
+
+size_t bench_thp_bytes(void)
+{
+    char line[128];
+    unsigned long long kb = 0;
+    FILE *f = fopen("/proc/self/smaps_rollup", "r");
+    if (!f)
+        return 0;
+    while (fgets(line, sizeof(line), f))
+        if (sscanf(line, "AnonHugePages: %llu kB", &kb) == 1)
+            break;
+    fclose(f);
+    return (size_t)kb << 10;
+}
+
+size_t bench_corpus_bytes(void)
+{
+    return corpus_bytes;
+}
+
+static size_t gcd(size_t a, size_t b)
+{
+    while (b)
+    {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+void bench_ring_init(bench_ring *r, const void *src, size_t len)
+{
+    /* Cache-line aligned slots, padded by one line to spread cache sets */
+    r->slot = ((len + 63) & ~(size_t)63) + 64;
+    r->count = 1;
+    if (cold_mode)
+    {
+        size_t total = llc_bytes * COLD_LLC_MULTIPLE;
+        if (total > COLD_MAX_BYTES)
+            total = COLD_MAX_BYTES;
+        r->count = total / r->slot + 1;
+    }
+    r->bytes = r->slot * r->count;
+    r->base = huge_mode != HUGE_NONE || numa_node >= 0 ? bench_alloc_large(r->bytes)
+                                                       : xmalloc(r->bytes);
+    for (size_t i = 0; i < r->count; i++)
+        memcpy(r->base + i * r->slot, src, len);
+    /* Stride near count * 0.618, coprime with count so every slot is visited */
+    r->step = 0;
+    if (r->count > 1)
+    {
+        r->step = (size_t)((double)r->count * 0.6180339887) | 1;
+        while (gcd(r->step, r->count) != 1)
+            r->step += 2;
+        r->step %= r->count;
+    }
+    r->pos = 0;
+}
+
+void bench_ring_free(bench_ring *r)
+{
+    if (huge_mode != HUGE_NONE || numa_node >= 0)
+        bench_free_large(r->base, r->bytes);
+    else
+        free(r->base);
+    r->base = NULL;
+}
+
+uint64_t bench_rand(void)
+{
+    uint64_t z = (rand_state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+/* Seed for one benchmark: the -s seed mixed with an FNV-1a hash of its name */
+static void reseed(const char *name)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (const char *p = name; *p; p++)
+        h = (h ^ (unsigned char)*p) * 0x100000001b3ull;
+    rand_state = seed ^ h;
+}
+
+/*
+ * Allocation counting. Built with -DBENCH_COUNT_ALLOCS and linked with
+ * -Wl,--wrap= for malloc, calloc, realloc, posix_memalign and aligned_alloc,
+ * every allocation in the binary goes through these wrappers. Only a static link also routes libc's
+ * internal allocations here; dynamic binaries count through the
+ * plugins/alloc_count.c shim that run.sh preloads, and report nothing without it.
+ */
+#ifdef BENCH_COUNT_ALLOCS
+#include <dlfcn.h>
+
+void *__real_malloc(size_t n);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t n);
+int __real_posix_memalign(void **p, size_t align, size_t n);
+void *__real_aligned_alloc(size_t align, size_t n);
+
+static uint64_t alloc_calls;
+
+void *__wrap_malloc(size_t n)
+{
+    alloc_calls++;
+    return __real_malloc(n);
+}
+void *__wrap_calloc(size_t n, size_t size)
+{
+    alloc_calls++;
+    return __real_calloc(n, size);
+}
+void *__wrap_realloc(void *p, size_t n)
+{
+    alloc_calls++;
+    return __real_realloc(p, n);
+}
+int __wrap_posix_memalign(void **p, size_t align, size_t n)
+{
+    alloc_calls++;
+    return __real_posix_memalign(p, align, n);
+}
+void *__wrap_aligned_alloc(size_t align, size_t n)
+{
+    alloc_calls++;
+    return __real_aligned_alloc(align, n);
+}
+#endif
+
+/* Allocations made so far, or -1 when they cannot be counted. */
+static int64_t allocations(void)
+{
+#ifdef BENCH_COUNT_ALLOCS
+    /* AT_BASE is the dynamic loader's address, 0 in a static binary */
+    if (getauxval(AT_BASE) == 0)
+        return (int64_t)alloc_calls;
+    /* The preloaded shim also sees the calls the wrappers forward */
+    static volatile uint64_t *shim_calls;
+    if (!shim_calls)
+        shim_calls = (volatile uint64_t *)dlsym(RTLD_DEFAULT, "libcbench_alloc_calls");
+    if (shim_calls)
+        return (int64_t)*shim_calls;
+#endif
+    return -1;
+}
+
+void bench_metric(const char *name, double value)
+{
+    size_t i = 0;
+    while (i < metric_count && strcmp(metric_names[i], name) != 0)
+        i++;
+    if (i == MAX_METRICS)
+        return;
+    if (i == metric_count)
+        metric_names[metric_count++] = name;
+    metric_values[i] = value;
+}
+
+void bench_skip(const char *reason)
+{
+    skip_reason = reason;
+}
+
+size_t bench_rss_bytes(void)
+{
+    unsigned long long size = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+    if (fscanf(f, "%llu %llu", &size, &resident) != 2)
+        resident = 0;
+    fclose(f);
+    return (size_t)resident * (size_t)sysconf(_SC_PAGESIZE);
+}
+
+static unsigned hist_index(uint64_t v)
+{
+    if (v < (1u << HIST_BITS))
+        return (unsigned)v;
+    unsigned msb = 63 - (unsigned)__builtin_clzll(v);
+    unsigned shift = msb - (HIST_BITS - 1);
+    return shift * HIST_HALF + (unsigned)(v >> shift);
+}
+
+/* Midpoint of the values that map to bucket idx. */
+static double hist_value(unsigned idx)
+{
+    if (idx < (1u << HIST_BITS))
+        return (double)idx;
+    unsigned shift = idx / HIST_HALF - 1;
+    uint64_t mantissa = idx - shift * HIST_HALF;
+    return (double)(mantissa << shift) + (double)(1ull << shift) / 2.0;
+}
+
+void bench_hist_record(bench_hist *h, uint64_t ticks)
+{
+    h->buckets[hist_index(ticks)]++;
+    h->count++;
+    h->sum += (double)ticks;
+    if (ticks > h->max)
+        h->max = ticks;
+}
+
+static double hist_percentile(const bench_hist *h, double pct)
+{
+    uint64_t rank = (uint64_t)((double)h->count * pct / 100.0);
+    if (rank >= h->count)
+        rank = h->count - 1;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < HIST_BUCKETS; i++)
+    {
+        seen += h->buckets[i];
+        if (seen > rank)
+            return hist_value(i);
+    }
+    return (double)h->max;
+}
+
+/* TSC ticks per ns, measured against CLOCK_MONOTONIC over ~50 ms. */
+static double tsc_per_ns(void)
+{
+    uint64_t t0 = now_ns(), c0 = bench_tsc_begin();
+    while (now_ns() - t0 < 50000000ull)
+        ;
+    uint64_t c1 = bench_tsc_end(), t1 = now_ns();
+    return (double)(c1 - c0) / (double)(t1 - t0);
+}
+
+/* Cost of an empty bench_tsc_begin/end pair, in ticks (median of many). */
+static uint64_t tsc_overhead(void)
+{
+    bench_hist *h = calloc(1, sizeof(*h));
+    if unlikely (!h)
+    {
+        bench_out_of_memory();
+    }
+    for (int i = 0; i < 100000; i++)
+    {
+        uint64_t t0 = bench_tsc_begin();
+        bench_hist_record(h, bench_tsc_end() - t0);
+    }
+    uint64_t overhead = (uint64_t)hist_percentile(h, 50.0);
+    free(h);
+    return overhead;
+}
+
+/* Runs b->latency for about target_ns and prints the percentile row. */
+static void measure_latency(const Benchmark *b, void *state, uint64_t target_ns,
+                            double ticks_per_ns, uint64_t overhead)
+{
+    bench_hist *h = calloc(1, sizeof(*h));
+    if unlikely (!h)
+    {
+        bench_out_of_memory();
+    }
+    /* Warm up, then start from an empty histogram */
+    b->latency(state, 1, h);
+    memset(h, 0, sizeof(*h));
+
+    uint64_t start = now_ns(), now = start;
+    size_t iters = 1;
+    while (now - start < target_ns)
+    {
+        uint64_t chunk = now;
+        b->latency(state, iters, h);
+        now = now_ns();
+        /* Grow chunks while they are short relative to the budget */
+        if (now - chunk < target_ns / 64)
+            iters *= 2;
+    }
+
+#define LAT_NS(ticks) ((ticks) > (double)overhead ? ((ticks) - (double)overhead) / ticks_per_ns : 0.0)
+    printf("%s,%llu,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+           b->name,
+           (unsigned long long)h->count,
+           LAT_NS(h->count ? h->sum / (double)h->count : 0.0),
+           LAT_NS(hist_percentile(h, 50.0)),
+           LAT_NS(hist_percentile(h, 99.0)),
+           LAT_NS(hist_percentile(h, 99.9)),
+           LAT_NS((double)h->max));
+#undef LAT_NS
+    free(h);
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-t budget_ms] [-r min_samples] [-e rse_pct] [-b pattern[,pattern...]] [-l] [-c] [-L] [-p]\n"
+                    "       [-s seed] [-j threads] [-H thp|hugetlb] [-N node] [-S corpus_mib]\n", prog);
+    fprintf(stderr, "  -t  time budget per benchmark (default 250 ms)\n");
+    fprintf(stderr, "  -r  minimum number of timed batches (default 10)\n");
+    fprintf(stderr, "  -e  stop once the relative standard error of ns/op is below this (default %.1f%%)\n",
+            target_rse * 100.0);
+    fprintf(stderr, "  -c  cold cache: rotate cache-sensitive kernels over a working set larger than the LLC\n");
+    fprintf(stderr, "  -L  per-call latency percentiles for benchmarks with a latency kernel\n");
+    fprintf(stderr, "  -p  input pool: run the randomized-input variants of the benchmarks\n");
+    fprintf(stderr, "  -s  seed for generated inputs (default %llu)\n", (unsigned long long)seed);
+    fprintf(stderr, "  -j  run each benchmark on this many threads at once (0: one per CPU)\n");
+    fprintf(stderr, "  -H  back large buffers with transparent huge pages or hugetlbfs pages\n");
+    fprintf(stderr, "  -N  bind large buffers to this NUMA node\n");
+    fprintf(stderr, "  -S  streaming: run the corpus benchmarks over a generated file of this many MiB\n");
+}
+
+/* The skeleton of a run(): the loop, the barrier and the op count */
+static size_t run_empty(void *state, size_t iters)
+{
+    (void)state;
+    size_t ops = 0;
+    for (size_t i = 0; i < iters; i++)
+    {
+        BENCH_CLOBBER_MEMORY();
+        ops++;
+    }
+    return ops;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Measures timer_ns (median of back-to-back reads) and loop_ns (fastest of
+   several empty runs, called through a pointer like a kernel). */
+static void measure_overhead(void)
+{
+    uint64_t reads[1001];
+    for (size_t i = 0; i < sizeof(reads) / sizeof(reads[0]); i++)
+    {
+        uint64_t t0 = now_ns();
+        reads[i] = now_ns() - t0;
+    }
+    qsort(reads, sizeof(reads) / sizeof(reads[0]), sizeof(reads[0]), cmp_u64);
+    timer_ns = (double)reads[500];
+
+    size_t (*volatile run)(void *, size_t) = run_empty;
+    size_t iters = 1u << 20;
+    loop_ns = -1.0;
+    for (int r = 0; r < 11; r++)
+    {
+        uint64_t t0 = now_ns();
+        run(NULL, iters);
+        double ns = ((double)(now_ns() - t0) - timer_ns) / (double)iters;
+        if (loop_ns < 0.0 || ns < loop_ns)
+            loop_ns = ns > 0.0 ? ns : 0.0;
+    }
+}
+
+/* Returns non-zero if name matches one of the comma-separated glob patterns. */
+static int selected(const char *name, const char *filter)
+{
+    if (!filter)
+        return 1;
+    char pat[128];
+    const char *p = filter;
+    while (*p)
+    {
+        size_t n = strcspn(p, ",");
+        if (n > 0 && n < sizeof(pat))
+        {
+            memcpy(pat, p, n);
+            pat[n] = '\0';
+            if (fnmatch(pat, name, 0) == 0)
+                return 1;
+        }
+        p += n;
+        if (*p == ',')
+            p++;
+    }
+    return 0;
+}
+
+/*
+ * Returns the iteration count whose run takes about batch_ns: doubles from
+ * one until a run takes an eighth of it, then scales. The last doubling run
+ * also counts allocations per op.
+ */
+static size_t calibrate(const Benchmark *b, void *state, uint64_t batch_ns)
+{
+    size_t iters = 1;
+    uint64_t elapsed_ns;
+    while (1)
+    {
+        int64_t allocs = allocations();
+        uint64_t start = now_ns();
+        size_t operations = b->run(state, iters);
+        elapsed_ns = now_ns() - start;
+        if (allocs >= 0 && operations)
+            bench_metric("allocs_per_op", (double)(allocations() - allocs) / (double)operations);
+        if (elapsed_ns >= batch_ns / 8 || iters >= (1ull << 30))
+            break;
+        iters *= 2;
+    }
+    if (elapsed_ns >= batch_ns)
+        return iters;
+    double scaled = (double)iters * (double)batch_ns / (double)(elapsed_ns ? elapsed_ns : 1);
+    return scaled < (double)(1ull << 32) ? (size_t)scaled : ((size_t)1 << 32);
+}
+
+/*
+ * Samples b in calibrated batches until the target relative standard error
+ * or the budget is reached (after at least min_samples batches) and prints
+ * its CSV row. ns/op is net of the timer and empty-loop overhead.
+ */
+static void measure(const Benchmark *b, void *state, uint64_t budget_ns, size_t min_samples,
+                    double ticks_per_ns)
+{
+    uint64_t batch_ns = budget_ns / BATCHES_PER_BUDGET;
+    if (batch_ns < (uint64_t)(TIMER_MULTIPLE * timer_ns))
+        batch_ns = (uint64_t)(TIMER_MULTIPLE * timer_ns);
+    size_t iters = calibrate(b, state, batch_ns);
+    double overhead_ns = timer_ns + (double)iters * loop_ns;
+
+    size_t operations = 0, samples = 0;
+    uint64_t elapsed_ns = 0;
+    double net_ns = 0.0, mean = 0.0, m2 = 0.0, rse = INFINITY;
+    uint64_t begin = now_ns();
+    while (samples < min_samples || (rse > target_rse && now_ns() - begin < budget_ns))
+    {
+        uint64_t start = now_ns();
+        size_t ops = b->run(state, iters);
+        uint64_t ns = now_ns() - start;
+        double net = (double)ns > overhead_ns ? (double)ns - overhead_ns : 0.0;
+        operations += ops;
+        elapsed_ns += ns;
+        net_ns += net;
+        /* Welford's running mean and variance of the per-batch ns/op */
+        double x = ops ? net / (double)ops : 0.0, delta = x - mean;
+        samples++;
+        mean += delta / (double)samples;
+        m2 += delta * (x - mean);
+        if (samples > 1)
+            rse = mean > 0.0 ? sqrt(m2 / (double)(samples - 1) / (double)samples) / mean : 0.0;
+    }
+
+    double ns_per_op = operations ? net_ns / (double)operations : 0.0;
+    double ops_per_sec = net_ns > 0.0 ? (double)operations * 1e9 / net_ns : 0.0;
+    double sd = samples > 1 ? sqrt(m2 / (double)(samples - 1)) : 0.0;
+
+    /* Cycles are TSC ticks, so this assumes the core runs near its base clock */
+    double bytes_per_cycle = 0.0;
+    if (b->bytes && ns_per_op > 0.0)
+        bytes_per_cycle = (double)b->bytes / (ns_per_op * ticks_per_ns);
+    int suspect = bytes_per_cycle > MAX_BYTES_PER_CYCLE;
+    if (suspect)
+        fprintf(stderr, "WARNING: %s: %.2f ns/op implies %.0f bytes/cycle; the work was likely optimized away\n",
+                b->name, ns_per_op, bytes_per_cycle);
+
+    printf("%s,%llu,%llu,%.2f,%.2f,%zu,%.4f,%.3f,%.2f,%d,",
+           b->name,
+           (unsigned long long)operations,
+           (unsigned long long)elapsed_ns,
+           ns_per_op,
+           ops_per_sec,
+           samples,
+           sd,
+           isfinite(rse) ? rse * 100.0 : 0.0,
+           bytes_per_cycle,
+           suspect);
+    for (size_t i = 0; i < metric_count; i++)
+        printf("%s%s=%.6g", i ? ";" : "", metric_names[i], metric_values[i]);
+    printf("\n");
+}
+
+/*
+ * Concurrent mode (-j). Threads get the same stack size under both libcs
+ * (musl's default is 128 KiB, glibc's follows ulimit -s).
+ */
+#define THREAD_STACK (1u << 20)
+
+typedef struct
+{
+    const Benchmark *b;
+    void *state;
+    size_t iters;
+    pthread_barrier_t *start;
+    size_t operations;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+} worker;
+
+static void *worker_main(void *arg)
+{
+    worker *w = (worker *)arg;
+    pthread_barrier_wait(w->start);
+    w->begin_ns = now_ns();
+    w->operations = w->b->run(w->state, w->iters);
+    w->end_ns = now_ns();
+    return NULL;
+}
+
+/*
+ * Measures b alone on states[0], then on all threads at once, each on its
+ * own state and with the same iteration count, and prints the aggregate
+ * throughput and the per-thread slowdown against the single-thread run.
+ */
+static void measure_concurrent(const Benchmark *b, void **states, uint64_t target_ns, size_t samples)
+{
+    /* The budget is shared by the samples, as in measure() */
+    size_t iters = calibrate(b, states[0], target_ns / samples);
+    size_t base_ops = 0;
+    uint64_t base_ns = 0;
+    for (size_t r = 0; r < samples; r++)
+    {
+        uint64_t start = now_ns();
+        base_ops += b->run(states[0], iters);
+        base_ns += now_ns() - start;
+    }
+
+    worker *w = xmalloc(threads * sizeof(*w));
+    pthread_t *tid = xmalloc(threads * sizeof(*tid));
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK);
+    size_t operations = 0;
+    uint64_t wall_ns = 0, busy_ns = 0;
+    for (size_t r = 0; r < samples; r++)
+    {
+        pthread_barrier_t start;
+        pthread_barrier_init(&start, NULL, (unsigned)threads);
+        for (size_t t = 0; t < threads; t++)
+        {
+            w[t] = (worker){b, states[t], iters, &start, 0, 0, 0};
+            if (pthread_create(&tid[t], &attr, worker_main, &w[t]) != 0)
+            {
+                fprintf(stderr, "cannot start thread %zu of %zu\n", t + 1, threads);
+                exit(1);
+            }
+        }
+        uint64_t first = UINT64_MAX, last = 0;
+        for (size_t t = 0; t < threads; t++)
+        {
+            pthread_join(tid[t], NULL);
+            operations += w[t].operations;
+            busy_ns += w[t].end_ns - w[t].begin_ns;
+            if (w[t].begin_ns < first)
+                first = w[t].begin_ns;
+            if (w[t].end_ns > last)
+                last = w[t].end_ns;
+        }
+        wall_ns += last - first;
+        pthread_barrier_destroy(&start);
+    }
+    pthread_attr_destroy(&attr);
+    free(tid);
+    free(w);
+
+    double base_per_op = base_ops ? (double)base_ns / (double)base_ops : 0.0;
+    double ns_per_op = operations ? (double)busy_ns / (double)operations : 0.0;
+    double ops_per_sec = wall_ns ? (double)operations * 1e9 / (double)wall_ns : 0.0;
+    printf("%s,%zu,%llu,%llu,%.2f,%.2f,%.2f,%.3f\n",
+           b->name,
+           threads,
+           (unsigned long long)operations,
+           (unsigned long long)wall_ns,
+           ops_per_sec,
+           ns_per_op,
+           base_per_op,
+           base_per_op > 0.0 ? ns_per_op / base_per_op : 0.0);
+}
+
+int bench_main(int argc, char **argv)
+{
+    uint64_t target_ms = 250;
+    size_t samples = 10;
+    const char *filter = NULL;
+    int list = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            target_ms = (uint64_t)strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            samples = (size_t)strtoull(argv[++i], NULL, 10);
+            if (samples == 0)
+                samples = 1;
+        }
+        else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc)
+        {
+            target_rse = strtod(argv[++i], NULL) / 100.0;
+        }
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "-l") == 0)
+        {
+            list = 1;
+        }
+        else if (strcmp(argv[i], "-c") == 0)
+        {
+            cold_mode = 1;
+        }
+        else if (strcmp(argv[i], "-L") == 0)
+        {
+            latency_mode = 1;
+        }
+        else if (strcmp(argv[i], "-p") == 0)
+        {
+            pool_mode = 1;
+        }
+        else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc)
+        {
+            seed = (uint64_t)strtoull(argv[++i], NULL, 0);
+        }
+        else if (strcmp(argv[i], "-H") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "thp") == 0)
+                huge_mode = HUGE_THP;
+            else if (strcmp(argv[i], "hugetlb") == 0)
+                huge_mode = HUGE_TLB;
+            else
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-N") == 0 && i + 1 < argc)
+        {
+            numa_node = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-S") == 0 && i + 1 < argc)
+        {
+            corpus_bytes = (size_t)strtoull(argv[++i], NULL, 10) << 20;
+            if (corpus_bytes == 0)
+            {
+                usage(argv[0]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            threads = (size_t)strtoull(argv[++i], NULL, 10);
+            if (threads == 0)
+                threads = (size_t)sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        else
+        {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (threads && latency_mode)
+    {
+        fprintf(stderr, "-j and -L cannot be combined\n");
+        return 1;
+    }
+    uint64_t target_ns = target_ms * 1000000ull;
+    if (cold_mode)
+        llc_bytes = detect_llc();
+
+    size_t count = registry_len;
+    if (list)
+    {
+        for (size_t i = 0; i < count; i++)
+            if (selected(registry[i]->name, filter))
+                printf("%s\n", registry[i]->name);
+        return 0;
+    }
+
+    double ticks_per_ns = tsc_per_ns();
+    uint64_t overhead = 0;
+    if (latency_mode)
+    {
+        overhead = tsc_overhead();
+        printf("benchmark,calls,mean_ns,p50_ns,p99_ns,p999_ns,max_ns\n");
+    }
+    else if (threads)
+        printf("benchmark,threads,operations,time_ns,ops_per_sec,ns_per_op,baseline_ns_per_op,slowdown\n");
+    else
+    {
+        measure_overhead();
+        fprintf(stderr, "timer overhead %.1f ns, empty loop %.3f ns/iteration\n", timer_ns, loop_ns);
+        printf("benchmark,operations,time_ns,ns_per_op,ops_per_sec,samples,ns_per_op_sd,rse_pct,"
+               "bytes_per_cycle,suspect,metrics\n");
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const Benchmark *b = registry[i];
+        if (!selected(b->name, filter))
+            continue;
+        if (cold_mode && !(b->flags & BENCH_F_CACHE))
+            continue;
+        if (latency_mode && !b->latency)
+            continue;
+        if (!pool_mode != !(b->flags & BENCH_F_POOL))
+            continue;
+        if (!corpus_bytes != !(b->flags & BENCH_F_STREAM))
+            continue;
+        if (threads && (b->flags & BENCH_F_NOT_MT))
+            continue;
+        void *state = NULL;
+        reseed(b->name);
+        metric_count = 0;
+        skip_reason = NULL;
+        if (b->init)
+            b->init(&state);
+        if (skip_reason)
+            fprintf(stderr, "skipping %s: %s\n", b->name, skip_reason);
+        else if (threads)
+        {
+            /* One state per thread, each from a freshly seeded init */
+            void **states = xmalloc(threads * sizeof(*states));
+            states[0] = state;
+            for (size_t t = 1; t < threads; t++)
+            {
+                states[t] = NULL;
+                reseed(b->name);
+                if (b->init)
+                    b->init(&states[t]);
+            }
+            measure_concurrent(b, states, target_ns, samples);
+            for (size_t t = 1; t < threads; t++)
+                if (b->cleanup)
+                    b->cleanup(states[t]);
+            free(states);
+        }
+        else if (latency_mode)
+            measure_latency(b, state, target_ns, ticks_per_ns, overhead);
+        else
+            measure(b, state, target_ns, samples, ticks_per_ns);
+        if (b->cleanup)
+            b->cleanup(state);
+    }
+    return 0;
+}
@@ -0,0 +1,226 @@
+#ifndef LIBCBENCH_H
+#define LIBCBENCH_H
+
+/*
+ * libcbench: the measurement harness behind benchmark.c.
+ *
+ * A benchmark is an init/run/cleanup triple. run(state, iters) performs
+ * `iters` rounds of work and returns the number of operations it did; the
+ * harness calibrates iters, repeats the run, and prints one CSV row per
+ * benchmark. Kernels in any translation unit linked with libcbench.c
+ * register themselves at load time:
+ *
+ *     static size_t run_mine(void *state, size_t iters) { ... }
+ *     BENCH_REGISTER("my_kernel", NULL, run_mine, NULL)
+ *
+ * and bench_main() runs everything that was registered.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#ifndef CLOCK_MONOTONIC
+#define CLOCK_MONOTONIC 1
+#endif
+
+typedef struct bench_hist bench_hist;
+
+typedef struct
+{
+    const char *name;
+    void (*init)(void **state);
+    size_t (*run)(void *state, size_t iters);
+    void (*cleanup)(void *state);
+    unsigned flags; /* BENCH_F_* */
+    /* Optional per-call variant of run for latency mode (-L): times every
+       call with bench_tsc_begin/end and records it in h. */
+    size_t (*latency)(void *state, size_t iters, bench_hist *h);
+    /* Lower bound on the bytes one operation must read plus write, for the
+       plausibility check; 0 skips it. */
+    size_t bytes;
+} Benchmark;
+
+/* Kernel works on replicated buffers (bench_ring) and runs in cold mode (-c). */
+#define BENCH_F_CACHE 0x1u
+/* Input-pool variant of the same-named benchmark; runs only under -p. */
+#define BENCH_F_POOL 0x2u
+/* Kernel mutates process-wide state (strtok's position, the environment, TZ)
+   or uses non-reentrant calls; left out of concurrent mode (-j). */
+#define BENCH_F_NOT_MT 0x4u
+/* Kernel streams the on-disk corpus (bench_corpus_bytes); runs only under -S. */
+#define BENCH_F_STREAM 0x8u
+
+/* Registry. Entries are not copied and must outlive bench_main(). */
+void bench_register(const Benchmark *b);
+void bench_register_table(const Benchmark *table, size_t count);
+
+/* Parses the command line, runs every selected benchmark, prints CSV. */
+int bench_main(int argc, char **argv);
+
+/*
+ * Compiler barriers for kernels. BENCH_DO_NOT_OPTIMIZE(x) makes the value of
+ * x observable, so the call producing it cannot be dropped, and clobbers
+ * memory, so a call with the same arguments in the next iteration cannot be
+ * hoisted out of the loop or merged with this one (a store to a volatile does
+ * neither). BENCH_CLOBBER_MEMORY() is the memory part alone, for kernels
+ * whose result lives in a buffer. Every run/latency loop passes each result
+ * through one of them.
+ */
+#define BENCH_DO_NOT_OPTIMIZE(x) __asm__ volatile("" : : "r,m"(x) : "memory")
+#define BENCH_CLOBBER_MEMORY() __asm__ volatile("" : : : "memory")
+
+/* Time utility */
+static inline uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/*
+ * Serialized cycle counter for per-call timing: lfence+rdtsc before the call,
+ * rdtscp+lfence after it, so the measured instructions cannot drift outside
+ * the window. Elsewhere both fall back to now_ns(). Ticks are converted to ns
+ * by the harness.
+ */
+#if defined(__x86_64__) || defined(__i386__)
+static inline uint64_t bench_tsc_begin(void)
+{
+    uint32_t lo, hi;
+    __asm__ volatile("lfence\n\trdtsc" : "=a"(lo), "=d"(hi)::"memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+static inline uint64_t bench_tsc_end(void)
+{
+    uint32_t lo, hi, aux;
+    __asm__ volatile("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi), "=c"(aux)::"memory");
+    return ((uint64_t)hi << 32) | lo;
+}
+#else
+static inline uint64_t bench_tsc_begin(void) { return now_ns(); }
+static inline uint64_t bench_tsc_end(void) { return now_ns(); }
+#endif
+
+/*
+ * Reproducible pseudo-random numbers for building inputs (splitmix64). The
+ * generator is reseeded from -s and the benchmark name before every init, so
+ * a benchmark sees the same inputs regardless of which others run, and both
+ * libcs see identical data (unlike rand()).
+ */
+uint64_t bench_rand(void);
+
+/* Uniform in [lo, hi] */
+static inline size_t bench_rand_range(size_t lo, size_t hi)
+{
+    return lo + (size_t)(bench_rand() % (uint64_t)(hi - lo + 1));
+}
+
+/* Adds one call of `ticks` cycles to a latency histogram. */
+void bench_hist_record(bench_hist *h, uint64_t ticks);
+
+/*
+ * Attaches a named value to the current benchmark's CSV row (metrics column,
+ * "name=value" pairs separated by ';'). Call from init or run; `name` must be
+ * a string literal or otherwise outlive the row. Reset before every init.
+ */
+void bench_metric(const char *name, double value);
+
+/*
+ * Called from init when the benchmark cannot run in this build or
+ * environment: the harness prints `reason` (a string literal) to stderr,
+ * emits no row and still calls cleanup.
+ */
+void bench_skip(const char *reason);
+
+/* Resident set size of the process in bytes (0 if unavailable). */
+size_t bench_rss_bytes(void);
+
+/*
+ * Page-granular buffer for large working sets, mapped directly rather than
+ * through malloc. With -H thp it is 2 MiB aligned and madvised for
+ * transparent huge pages, with -H hugetlb it comes from hugetlbfs (falling
+ * back to THP), and with -N node it is bound to that NUMA node. Free with
+ * the same len. Rings switch to it when -H or -N is given.
+ */
+void *bench_alloc_large(size_t len);
+void bench_free_large(void *p, size_t len);
+
+/* AnonHugePages of the process in bytes (0 if unavailable). */
+size_t bench_thp_bytes(void);
+
+/* Corpus size requested with -S, in bytes; 0 outside streaming mode. */
+size_t bench_corpus_bytes(void);
+
+#if defined(__GNUC__) || defined(__clang__)
+#define likely(x) (__builtin_expect(!!(x), 1))
+#define unlikely(x) (__builtin_expect(!!(x), 0))
+#else
+#define likely(x) (x)
+#define unlikely(x) (x)
+#endif
+
+void bench_out_of_memory(void);
+
+static inline void *xmalloc(size_t n)
+{
+    void *p = malloc(n ? n : 1);
+    if unlikely (!p)
+    {
+        bench_out_of_memory();
+    }
+    return p;
+}
+
+/*
+ * Working-set rotation for cache-sensitive kernels. bench_ring_init copies a
+ * len-byte template into `count` slots: one normally, enough to cover several
+ * times the last-level cache in cold mode (-c), so every call touches memory
+ * that was evicted since its previous use. bench_ring_next walks the slots
+ * with a large stride to keep the hardware prefetcher from following along.
+ */
+typedef struct
+{
+    unsigned char *base;
+    size_t slot;
+    size_t count;
+    size_t step;
+    size_t pos;
+    size_t bytes; /* allocation size */
+} bench_ring;
+
+void bench_ring_init(bench_ring *r, const void *src, size_t len);
+void bench_ring_free(bench_ring *r);
+
+static inline void *bench_ring_next(bench_ring *r)
+{
+    unsigned char *p = r->base + r->pos * r->slot;
+    r->pos += r->step;
+    if (r->pos >= r->count)
+        r->pos -= r->count;
+    return p;
+}
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+/*
+ * BENCH_REGISTER("name", init, run, cleanup) defines and registers one
+ * benchmark; the arguments are a Benchmark initializer.
+ * BENCH_REGISTER_TABLE(table) registers every entry of a static array.
+ */
+#define BENCH_REGISTER(...)                                                        \
+    static const Benchmark BENCH_CONCAT(bench_entry_, __LINE__) = {__VA_ARGS__};  \
+    __attribute__((constructor)) static void BENCH_CONCAT(bench_ctor_, __LINE__)(void) \
+    {                                                                              \
+        bench_register(&BENCH_CONCAT(bench_entry_, __LINE__));                     \
+    }
+
+#define BENCH_REGISTER_TABLE(table)                                                \
+    __attribute__((constructor)) static void BENCH_CONCAT(bench_ctor_, __LINE__)(void) \
+    {                                                                              \
+        bench_register_table(table, sizeof(table) / sizeof((table)[0]));           \
+    }
+
+#endif /* LIBCBENCH_H */
@@ -0,0 +1,79 @@
+"""
+Convert an `ltrace -c` (or uprobe count) histogram into a workload profile.
+
+    ltrace -c -f -p <pid> 2> ltrace.txt   # while serving N requests
+    python ltrace2profile.py ltrace.txt N > profiles/myservice.profile
+
+Lines must end in "<calls> <function>" (the ltrace -c summary format).
+Functions without a matching benchmark are listed as comments so the
+profile can be edited by hand; weights default to 1.0.
+"""
+import sys
+from pathlib import Path
+
+# libc function -> benchmark that measures it
+FUNCTION_MAP = {
+    "strlen": "strlen",
+    "strcmp": "strcmp",
+    "strcpy": "strcpy",
+    "strcat": "strcat",
+    "strchr": "strchr",
+    "strrchr": "strrchr",
+    "strnlen": "strnlen",
+    "strncmp": "strncmp",
+    "strncpy": "strncpy",
+    "strncat": "strncat",
+    "strstr": "strstr_search",
+    "strtok": "strtok_parse",
+    "strtok_r": "strtok_r_parse",
+    "strtod": "strtod_parse",
+    "atoi": "atoi_parse",
+    "memcmp": "memcmp",
+    "memcpy": "memcpy",
+    "memmove": "memmove",
+    "qsort": "qsort_int",
+    "bsearch": "bsearch_int",
+    "malloc": "malloc_free_small",
+    "realloc": "realloc_pattern",
+    "sprintf": "sprintf_int",
+    "snprintf": "snprintf_mix",
+    "vsnprintf": "vsnprintf_mix",
+    "regexec": "regex_match",
+    "fgets": "fgets_read",
+    "getline": "getline_read",
+}
+
+
+def main():
+    if len(sys.argv) != 3:
+        print(f"Usage: {sys.argv[0]} ltrace.txt requests", file=sys.stderr)
+        return 1
+    requests = float(sys.argv[2])
+    if requests <= 0:
+        print("requests must be positive", file=sys.stderr)
+        return 1
+
+    calls = {}
+    unmapped = []
+    for line in Path(sys.argv[1]).read_text(encoding="utf-8").splitlines():
+        parts = line.split()
+        if len(parts) < 2 or not parts[-2].isdigit():
+            continue
+        func, count = parts[-1], int(parts[-2])
+        bench = FUNCTION_MAP.get(func)
+        if bench is None:
+            unmapped.append((func, count))
+            continue
+        calls[bench] = calls.get(bench, 0) + count
+
+    print(f"# Generated from {sys.argv[1]} over {requests:g} requests")
+    print("# benchmark  calls_per_request  weight")
+    for bench, count in sorted(calls.items()):
+        print(f"{bench} {count / requests:.4g}")
+    for func, count in sorted(unmapped):
+        print(f"# unmapped: {func} {count / requests:.4g}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
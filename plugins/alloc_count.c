@@ -0,0 +1,104 @@
+/*
+ * Allocation counter for dynamically linked cells. run.sh --allocs builds it
+ * per cell as benchmark-<label>.allocs.so with the cell's toolchain and
+ * LD_PRELOADs it into the allocs pass when the binary has a program
+ * interpreter; statically linked cells count through -Wl,--wrap instead.
+ *
+ * Being preloaded, its malloc, calloc, realloc, posix_memalign and
+ * aligned_alloc come first in symbol lookup, so calls from libc itself (and
+ * from what it dlopens, such as glibc's NSS modules) are counted too. The
+ * harness reads libcbench_alloc_calls through dlsym.
+ */
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+uint64_t libcbench_alloc_calls;
+
+#ifdef __GLIBC__
+/* glibc's own entry points: dlsym may allocate, so it cannot be used here */
+void *__libc_malloc(size_t n);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *p, size_t n);
+void *__libc_memalign(size_t align, size_t n);
+
+#define REAL_MALLOC __libc_malloc
+#define REAL_CALLOC __libc_calloc
+#define REAL_REALLOC __libc_realloc
+#define REAL_MEMALIGN __libc_memalign
+#else
+/* musl's dlsym does not allocate, so the next definition is looked up once */
+static void *(*next_malloc)(size_t);
+static void *(*next_calloc)(size_t, size_t);
+static void *(*next_realloc)(void *, size_t);
+static void *(*next_aligned_alloc)(size_t, size_t);
+
+static void *real_malloc(size_t n)
+{
+    if (!next_malloc)
+        next_malloc = (void *(*)(size_t))dlsym(RTLD_NEXT, "malloc");
+    return next_malloc(n);
+}
+static void *real_calloc(size_t n, size_t size)
+{
+    if (!next_calloc)
+        next_calloc = (void *(*)(size_t, size_t))dlsym(RTLD_NEXT, "calloc");
+    return next_calloc(n, size);
+}
+static void *real_realloc(void *p, size_t n)
+{
+    if (!next_realloc)
+        next_realloc = (void *(*)(void *, size_t))dlsym(RTLD_NEXT, "realloc");
+    return next_realloc(p, n);
+}
+static void *real_memalign(size_t align, size_t n)
+{
+    if (!next_aligned_alloc)
+        next_aligned_alloc = (void *(*)(size_t, size_t))dlsym(RTLD_NEXT, "aligned_alloc");
+    return next_aligned_alloc(align, n);
+}
+
+#define REAL_MALLOC real_malloc
+#define REAL_CALLOC real_calloc
+#define REAL_REALLOC real_realloc
+#define REAL_MEMALIGN real_memalign
+#endif
+
+void *malloc(size_t n)
+{
+    libcbench_alloc_calls++;
+    return REAL_MALLOC(n);
+}
+
+void *calloc(size_t n, size_t size)
+{
+    libcbench_alloc_calls++;
+    return REAL_CALLOC(n, size);
+}
+
+void *realloc(void *p, size_t n)
+{
+    libcbench_alloc_calls++;
+    return REAL_REALLOC(p, n);
+}
+
+int posix_memalign(void **p, size_t align, size_t n)
+{
+    libcbench_alloc_calls++;
+    /* Same checks as the libc: a power of two and a multiple of a pointer */
+    if (align < sizeof(void *) || (align & (align - 1)))
+        return EINVAL;
+    void *q = REAL_MEMALIGN(align, n);
+    if (!q)
+        return ENOMEM;
+    *p = q;
+    return 0;
+}
+
+void *aligned_alloc(size_t align, size_t n)
+{
+    libcbench_alloc_calls++;
+    return REAL_MEMALIGN(align, n);
+}
@@ -0,0 +1,38 @@
+/*
+ * Plugin loaded by the dlopen/dlsym benchmarks (kernels/dynlink.c). run.sh
+ * builds it per cell as benchmark-<label>.plugin.so with the cell's toolchain.
+ * It exports 256 functions, plugin_fn_000 .. plugin_fn_0ff, matching SYM_POOL
+ * in kernels/dynlink.c, so lookups go through a realistically sized symbol
+ * table.
+ */
+
+#define PLUGIN_FN(n) \
+    int plugin_fn_##n(int x) { return x + 0x##n; }
+#define PLUGIN_FN16(h)                                                               \
+    PLUGIN_FN(h##0) PLUGIN_FN(h##1) PLUGIN_FN(h##2) PLUGIN_FN(h##3) PLUGIN_FN(h##4) \
+    PLUGIN_FN(h##5) PLUGIN_FN(h##6) PLUGIN_FN(h##7) PLUGIN_FN(h##8) PLUGIN_FN(h##9) \
+    PLUGIN_FN(h##a) PLUGIN_FN(h##b) PLUGIN_FN(h##c) PLUGIN_FN(h##d) PLUGIN_FN(h##e) \
+    PLUGIN_FN(h##f)
+
+/* 256 functions, plugin_fn_000 .. plugin_fn_0ff */
+PLUGIN_FN16(00)
+PLUGIN_FN16(01)
+PLUGIN_FN16(02)
+PLUGIN_FN16(03)
+PLUGIN_FN16(04)
+PLUGIN_FN16(05)
+PLUGIN_FN16(06)
+PLUGIN_FN16(07)
+PLUGIN_FN16(08)
+PLUGIN_FN16(09)
+PLUGIN_FN16(0a)
+PLUGIN_FN16(0b)
+PLUGIN_FN16(0c)
+PLUGIN_FN16(0d)
+PLUGIN_FN16(0e)
+PLUGIN_FN16(0f)
+
+int plugin_symbol_count(void)
+{
+    return 256;
+}
@@ -0,0 +1,21 @@
+# Example: JSON/HTTP API front end, per request.
+# Counts from `ltrace -c` over 10k requests divided by the request count
+# (see ltrace2profile.py); weights scale each benchmark op to the typical
+# argument size seen in production.
+#
+# benchmark          calls_per_request  weight
+strlen               42                 0.05
+strcmp               18
+strncmp              12                 0.02
+strchr               9                  0.05
+memcpy               25                 0.02
+memcmp               6                  0.01
+malloc_free_small    60
+malloc_free_medium   3
+realloc_pattern      2
+snprintf_mix         8
+sprintf_int          14
+strtod_parse         4
+atoi_parse           6
+strstr_search        1                  0.1
+qsort_int            0.05
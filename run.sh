@@ -1,36 +1,374 @@
 #!/usr/bin/env bash
 set -euo pipefail
 
-SRC=benchmark.c
-CC="zig cc"
-CFLAGS="-std=c11 -O3 -march=native -mtune=native -flto=full -fomit-frame-pointer -funroll-loops -DNDEBUG -fno-math-errno -fno-trapping-math -g0 -s"
+# Build matrix. Every combination of these becomes one labeled cell with its
+# own binary and results/matrix/<label>.csv. Override from the environment,
+# e.g. COMPILERS="zig gcc" OPT_LEVELS="-O2 -O3" MARCHES="native x86-64-v2" ./run.sh
+#   COMPILERS:  zig gcc clang (gcc/clang target musl via musl-gcc/musl-clang)
+#   LIBCS:      gnu musl
+#   OPT_LEVELS: any -O flag
+#   MARCHES:    native or a -march level (x86-64, x86-64-v2, x86-64-v3, ...)
+#   LINKS:      default (toolchain default), static, dynamic
+#   ALLOCATORS: system and/or name=path entries; path is a malloc replacement
+#               built for the target libc: .a/.o is linked in, .so is
+#               LD_PRELOADed (dynamic cells only). "{libc}" in the path is
+#               replaced by gnu/musl, e.g. mimalloc=/opt/{libc}/libmimalloc.a
+#               Non-system cells only run the ALLOC_BENCHMARKS patterns.
+COMPILERS=${COMPILERS:-zig}
+LIBCS=${LIBCS:-"gnu musl"}
+OPT_LEVELS=${OPT_LEVELS:--O3}
+MARCHES=${MARCHES:-native}
+LINKS=${LINKS:-default}
+ALLOCATORS=${ALLOCATORS:-system}
+ALLOC_BENCHMARKS=${ALLOC_BENCHMARKS:-"malloc_*,realloc_*,calloc_*,posix_memalign_*,aligned_alloc_*"}
+ALLOC_LDLIBS=${ALLOC_LDLIBS:--lpthread}
+# Benchmarks rerun by --hugepages (memory kernels, file I/O and allocators)
+HUGE_BENCHMARKS=${HUGE_BENCHMARKS:-"mem*,file_io_rw,malloc_*,realloc_*,calloc_*,posix_memalign_*,aligned_alloc_*"}
+# Patterns profiled by --profile, one flame graph per pattern and libc
+PROFILE_BENCHMARKS=${PROFILE_BENCHMARKS:-"strlen,strcmp,strncmp,memcpy,qsort_int,malloc_free_small,snprintf_mix"}
+JOBS=${JOBS:-$(nproc)}
+BENCH_ARGS=${BENCH_ARGS:-}
+# Additional kernel translation units; kernels/*.c is always included.
+EXTRA_SRC=${EXTRA_SRC:-}
 
-if [[ ! -f $SRC ]]; then
-    echo "Source file $SRC not found" >&2
+# Extra measurement passes per cell as "suffix:benchmark args"; each writes
+# results/matrix/<label>.<suffix>.csv next to the default pass. A pass runs
+# benchmark-<label>.<suffix> instead of the cell's binary when one was built.
+PASSES=()
+COUNT_ALLOCS=0
+FOOTPRINT=0
+PROFILE=0
+
+usage() {
+    echo "Usage: $0 [--link-compare] [--cold] [--latency] [--pool] [--allocs] [--concurrent] [--hugepages] [--footprint] [--profile] [--stream]" >&2
+    echo "  --link-compare  build every libc both statically and dynamically linked" >&2
+    echo "  --cold          also measure mem*/str* kernels with a working set larger than the LLC" >&2
+    echo "  --latency       also record per-call latency percentiles (allocator, stdio, regex)" >&2
+    echo "  --pool          also measure string/parse kernels on randomized input pools" >&2
+    echo "  --allocs        also count allocations per operation (--wrap when static, a preloaded shim when dynamic)" >&2
+    echo "  --concurrent    also run every benchmark on all CPUs at once (THREADS to override)" >&2
+    echo "  --hugepages     also run memory benchmarks on huge pages (HUGE_MODE, NUMA_NODE)" >&2
+    echo "  --footprint     also record binary, section and startup sizes and build times (builds serially)" >&2
+    echo "  --profile       also record perf flame graphs of PROFILE_BENCHMARKS per libc" >&2
+    echo "  --stream        also split a generated CORPUS_MIB (1024) MiB log file into lines" >&2
+}
+
+while (($#)); do
+    case $1 in
+    --link-compare) LINKS="static dynamic" ;;
+    --cold) PASSES+=("cold:-c") ;;
+    --latency) PASSES+=("latency:-L") ;;
+    --pool) PASSES+=("pool:-p") ;;
+    --concurrent) PASSES+=("mt:-j ${THREADS:-0}") ;;
+    --hugepages)
+        huge_args="-H ${HUGE_MODE:-thp} -b $HUGE_BENCHMARKS"
+        [[ -n ${NUMA_NODE:-} ]] && huge_args+=" -N $NUMA_NODE"
+        PASSES+=("huge:$huge_args")
+        ;;
+    --footprint) FOOTPRINT=1 ;;
+    --profile) PROFILE=1 ;;
+    --stream) PASSES+=("stream:-S ${CORPUS_MIB:-1024}") ;;
+    --allocs)
+        COUNT_ALLOCS=1
+        PASSES+=("allocs:-t 20 -r 1")
+        ;;
+    *)
+        usage
+        exit 1
+        ;;
+    esac
+    shift
+done
+# Build times are only comparable when builds do not share the machine
+((FOOTPRINT)) && JOBS=1
+
+SRC="benchmark.c libcbench.c"
+for src in kernels/*.c; do
+    [[ -f $src ]] && SRC+=" $src"
+done
+SRC+=" $EXTRA_SRC"
+CFLAGS="-std=c11 -fomit-frame-pointer -funroll-loops -DNDEBUG -fno-math-errno -fno-trapping-math -g0 -s"
+LDLIBS="-lm -ldl -lpthread"
+MATRIX_DIR=results/matrix
+
+for src in $SRC; do
+    if [[ ! -f $src ]]; then
+        echo "Source file $src not found" >&2
+        exit 1
+    fi
+done
+
+# Prints the compiler driver for a compiler/libc pair, or nothing when the
+# toolchain is not installed.
+cc_for() {
+    local compiler=$1 libc=$2
+    case $compiler in
+    zig)
+        command -v zig >/dev/null && echo "zig cc -target x86_64-linux-$libc"
+        ;;
+    gcc | clang)
+        local driver=$compiler
+        [[ $libc == musl ]] && driver=musl-$compiler
+        command -v "$driver" >/dev/null && echo "$driver"
+        ;;
+    esac
+    return 0
+}
+
+flags_for() {
+    local compiler=$1 opt=$2 march=$3 link=$4
+    local flags="$CFLAGS $opt"
+    if [[ $march == native ]]; then
+        flags+=" -march=native -mtune=native"
+    else
+        flags+=" -march=$march -mtune=generic"
+    fi
+    if [[ $compiler == gcc ]]; then
+        flags+=" -flto"
+    else
+        flags+=" -flto=full"
+    fi
+    case $link in
+    static) flags+=" -static" ;;
+    dynamic) [[ $compiler == zig ]] && flags+=" -dynamic" ;;
+    esac
+    echo "$flags"
+}
+
+mkdir -p "$MATRIX_DIR"
+rm -f "$MATRIX_DIR"/*.csv "$MATRIX_DIR"/*.log "$MATRIX_DIR"/*.build_ms "$MATRIX_DIR"/*.txt
+echo "label,compiler,libc,opt,march,link,alloc" >"$MATRIX_DIR/cells.csv"
+
+labels=()
+declare -A preload=() filter=() cc_of=() flags_of=() libs_of=()
+for compiler in $COMPILERS; do
+    for libc in $LIBCS; do
+        cc=$(cc_for "$compiler" "$libc")
+        if [[ -z $cc ]]; then
+            echo "Skipping $compiler/$libc: toolchain not found" >&2
+            continue
+        fi
+        for opt in $OPT_LEVELS; do
+            for march in $MARCHES; do
+                for link in $LINKS; do
+                    for alloc in $ALLOCATORS; do
+                        name=${alloc%%=*}
+                        base="$compiler-$libc-${opt#-}-$march-$link"
+                        label=$base
+                        flags=$(flags_for "$compiler" "$opt" "$march" "$link")
+                        libs=$LDLIBS
+                        if [[ $name != system ]]; then
+                            path=${alloc#*=}
+                            path=${path//\{libc\}/$libc}
+                            label="$base+$name"
+                            if [[ ! -f $path ]]; then
+                                echo "Skipping $label: $path not found" >&2
+                                continue
+                            fi
+                            case $path in
+                            *.so | *.so.*)
+                                if [[ $link == static ]]; then
+                                    echo "Skipping $label: cannot LD_PRELOAD into a static binary" >&2
+                                    continue
+                                fi
+                                preload[$label]=$(realpath "$path")
+                                ;;
+                            *) libs="$path $ALLOC_LDLIBS $LDLIBS" ;;
+                            esac
+                            filter[$label]=$ALLOC_BENCHMARKS
+                        fi
+                        echo "Building $label..."
+                        rm -f "benchmark-$label"
+                        cc_of[$label]=$cc flags_of[$label]=$flags libs_of[$label]=$libs
+                        # shellcheck disable=SC2086
+                        (
+                            start=$(date +%s%N)
+                            $cc $SRC -o "benchmark-$label" $flags $libs &&
+                                echo $((($(date +%s%N) - start) / 1000000)) >"$MATRIX_DIR/$label.build_ms"
+                        ) >"$MATRIX_DIR/$label.build.log" 2>&1 &
+                        # build_ms is only comparable when nothing else compiles
+                        # alongside, so the plugin and allocs builds start after it
+                        ((FOOTPRINT)) && { wait $! || true; }
+                        if [[ $name == system ]]; then
+                            # Plugin for the dlopen/dlsym benchmarks, built by the
+                            # same toolchain so it links against the cell's libc
+                            rm -f "benchmark-$label.plugin.so"
+                            # shellcheck disable=SC2086
+                            $cc plugins/bench_plugin.c -o "benchmark-$label.plugin.so" $opt -fPIC -shared \
+                                >"$MATRIX_DIR/$label.plugin.build.log" 2>&1 &
+                        fi
+                        if ((COUNT_ALLOCS)) && [[ $name == system ]]; then
+                            # Same cell with every malloc/calloc/realloc/aligned allocation counted
+                            rm -f "benchmark-$label.allocs"
+                            # shellcheck disable=SC2086
+                            $cc $SRC -o "benchmark-$label.allocs" $flags -DBENCH_COUNT_ALLOCS \
+                                -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,--wrap=posix_memalign,--wrap=aligned_alloc $libs \
+                                >"$MATRIX_DIR/$label.allocs.build.log" 2>&1 &
+                            # Counting shim preloaded when that binary turns out dynamic
+                            rm -f "benchmark-$label.allocs.so"
+                            # shellcheck disable=SC2086
+                            $cc plugins/alloc_count.c -o "benchmark-$label.allocs.so" $opt -fPIC -shared -ldl \
+                                >"$MATRIX_DIR/$label.allocs.so.build.log" 2>&1 &
+                        fi
+                        labels+=("$label")
+                        echo "$label,$compiler,$libc,$opt,$march,$link,$name" >>"$MATRIX_DIR/cells.csv"
+                        while (($(jobs -rp | wc -l) >= JOBS)); do
+                            wait -n || true
+                        done
+                    done
+                done
+            done
+        done
+    done
+done
+
+wait
+
+# Succeeds when an ELF binary has a PT_INTERP header, i.e. is dynamically
+# linked and so honours LD_PRELOAD.
+has_interp() {
+    python - "$1" <<'EOF'
+import struct, sys
+with open(sys.argv[1], "rb") as f:
+    data = f.read()
+phoff, = struct.unpack_from("<Q", data, 0x20)
+phentsize, phnum = struct.unpack_from("<HH", data, 0x36)
+types = (struct.unpack_from("<I", data, phoff + i * phentsize)[0] for i in range(phnum))
+sys.exit(0 if 3 in types else 1)
+EOF
+}
+
+built=()
+for label in "${labels[@]}"; do
+    if [[ ! -x benchmark-$label ]]; then
+        echo "Build failed for $label, see $MATRIX_DIR/$label.build.log" >&2
+    elif [[ -n ${preload[$label]:-} ]] && ! has_interp "benchmark-$label"; then
+        # LINKS=default can still produce a static binary (zig's musl target)
+        echo "Skipping $label: statically linked, so LD_PRELOAD would not apply" >&2
+    else
+        built+=("$label")
+    fi
+done
+
+if ((${#built[@]} == 0)); then
+    echo "No benchmark binaries were built" >&2
     exit 1
 fi
 
-echo "Building (glibc)..."
-$CC -target x86_64-linux-gnu  $SRC -o benchmark-gnu  $CFLAGS
-echo "Building (musl)..."
-$CC -target x86_64-linux-musl $SRC -o benchmark-musl $CFLAGS
+# Footprint of each system-allocator cell: the same build without -s for
+# the symbol table, and an empty main with the cell's flags for startup cost.
+if ((FOOTPRINT)); then
+    for label in "${built[@]}"; do
+        [[ -n ${filter[$label]:-} ]] && continue
+        echo "Measuring footprint of $label..."
+        full_flags=
+        for flag in ${flags_of[$label]}; do
+            [[ $flag == -s ]] || full_flags+=" $flag"
+        done
+        # shellcheck disable=SC2086
+        ${cc_of[$label]} $SRC -o "benchmark-$label.full" $full_flags ${libs_of[$label]} \
+            >"$MATRIX_DIR/$label.footprint.log" 2>&1 &&
+            ${cc_of[$label]} footprint/empty_main.c -o "benchmark-$label.empty" ${flags_of[$label]} \
+                >>"$MATRIX_DIR/$label.footprint.log" 2>&1 &&
+            python footprint.py "benchmark-$label" "benchmark-$label.full" "benchmark-$label.empty" \
+                "$(cat "$MATRIX_DIR/$label.build_ms" 2>/dev/null)" "$MATRIX_DIR/$label.libc_functions.txt" \
+                >"$MATRIX_DIR/$label.footprint.csv" 2>>"$MATRIX_DIR/$label.footprint.log" ||
+            echo "Footprint failed for $label, see $MATRIX_DIR/$label.footprint.log" >&2
+    done
+fi
 
-mkdir -p results
-gnu_csv=results/benchmark-gnu.csv
-musl_csv=results/benchmark-musl.csv
+# Runs stay sequential so cells do not compete for the machine.
+for label in "${built[@]}"; do
+    echo "Running $label..."
+    read -ra args <<<"$BENCH_ARGS"
+    if [[ -n ${filter[$label]:-} ]]; then
+        # Allocator cells: only the allocator benchmarks, default pass only
+        LD_PRELOAD=${preload[$label]:-} "./benchmark-$label" "${args[@]}" \
+            -b "${filter[$label]}" >"$MATRIX_DIR/$label.csv"
+        sleep 3
+        continue
+    fi
+    export BENCH_PLUGIN=$PWD/benchmark-$label.plugin.so
+    "./benchmark-$label" "${args[@]}" >"$MATRIX_DIR/$label.csv"
+    sleep 3
+    for pass in "${PASSES[@]}"; do
+        read -ra pass_args <<<"${pass#*:}"
+        echo "Running $label (${pass%%:*})..."
+        bin=./benchmark-$label
+        [[ -x $bin.${pass%%:*} ]] && bin+=.${pass%%:*}
+        shim=
+        if [[ ${pass%%:*} == allocs && -f benchmark-$label.allocs.so ]] && has_interp "$bin"; then
+            shim=$PWD/benchmark-$label.allocs.so
+        fi
+        LD_PRELOAD=${shim:-${LD_PRELOAD:-}} "$bin" "${args[@]}" "${pass_args[@]}" >"$MATRIX_DIR/$label.${pass%%:*}.csv"
+        sleep 3
+    done
+done
 
-# remove old files if they exist
-rm -f "$gnu_csv" "$musl_csv"
+# The first system-allocator cell of each libc feeds the headline table.
+rm -f results/benchmark-gnu*.csv results/benchmark-musl*.csv
+for libc in gnu musl; do
+    for label in "${built[@]}"; do
+        if [[ $label == *-$libc-* && $label != *+* ]]; then
+            cp "$MATRIX_DIR/$label.csv" "results/benchmark-$libc.csv"
+            for pass in "${PASSES[@]}"; do
+                cp "$MATRIX_DIR/$label.${pass%%:*}.csv" "results/benchmark-$libc.${pass%%:*}.csv"
+            done
+            break
+        fi
+    done
+done
 
-echo "Running glibc binary..."
-./benchmark-gnu > "$gnu_csv"
-sleep 3
-echo "Running musl binary..."
-./benchmark-musl > "$musl_csv"
+# Flame graphs of the headline cells: rebuilt unstripped with frame pointers,
+# one perf record per PROFILE_BENCHMARKS pattern. flamegraph.pl draws the SVG
+# when installed, flamegraph.py otherwise.
+rm -rf results/profile
+if ((PROFILE)) && ! command -v perf >/dev/null; then
+    echo "Skipping --profile: perf not found" >&2
+elif ((PROFILE)); then
+    mkdir -p results/profile
+    for libc in gnu musl; do
+        for label in "${built[@]}"; do
+            [[ $label == *-$libc-* && $label != *+* ]] || continue
+            prof_flags="-g -fno-omit-frame-pointer -mno-omit-leaf-frame-pointer"
+            for flag in ${flags_of[$label]}; do
+                [[ $flag == -s || $flag == -g0 || $flag == -fomit-frame-pointer ]] || prof_flags+=" $flag"
+            done
+            echo "Profiling $label..."
+            # shellcheck disable=SC2086
+            if ! ${cc_of[$label]} $SRC -o "benchmark-$label.prof" $prof_flags ${libs_of[$label]} \
+                >"results/profile/$libc.build.log" 2>&1; then
+                echo "Profile build failed for $label, see results/profile/$libc.build.log" >&2
+                break
+            fi
+            export BENCH_PLUGIN=$PWD/benchmark-$label.plugin.so
+            read -ra args <<<"$BENCH_ARGS"
+            IFS=, read -ra patterns <<<"$PROFILE_BENCHMARKS"
+            for pattern in "${patterns[@]}"; do
+                out=results/profile/$libc.${pattern//[^A-Za-z0-9_]/_}
+                perf record -F "${PROFILE_FREQ:-997}" --call-graph "${PROFILE_CALLGRAPH:-fp}" \
+                    -o "$out.perf.data" -- "./benchmark-$label.prof" "${args[@]}" -b "$pattern" \
+                    >/dev/null 2>"$out.log" || echo "perf record failed for $pattern, see $out.log" >&2
+                perf script -i "$out.perf.data" 2>>"$out.log" | python flamegraph.py collapse >"$out.folded" ||
+                    echo "perf script failed for $pattern, see $out.log" >&2
+                title="$pattern ($label)"
+                if command -v flamegraph.pl >/dev/null; then
+                    flamegraph.pl --title "$title" "$out.folded" >"$out.svg"
+                else
+                    python flamegraph.py svg "$title" "$out.folded" >"$out.svg"
+                fi
+                rm -f "$out.perf.data"
+            done
+            break
+        done
+    done
+fi
 
-echo "Done. Files: $gnu_csv, $musl_csv"
+echo "Done. Results in $MATRIX_DIR"
 
 python generate.py
 
 # Cleanup
-rm -f benchmark-gnu benchmark-musl
\ No newline at end of file
+for label in "${built[@]}"; do
+    rm -f "benchmark-$label" "benchmark-$label".*
+done